@@ -0,0 +1,351 @@
+//
+//  Accuracy.cpp
+//  Battleship
+//
+
+#include "Accuracy.h"
+#include "Game.h"
+#include "Possibilities.h"
+#include "ShipShape.h"
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+double millis_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/*
+ What a position says about where each ship can be, as masks.
+ A placement fits ship s if it misses every miss, and then either s is sunk and the placement is all hits
+ including the one that sank it, or s is afloat and the placement isn't all hits (or s would have been sunk).
+ A whole layout fits if its ships don't overlap and cover every hit
+ */
+struct Known
+{
+    CellSet misses;
+    CellSet hits;
+    vector<vector<const ShipPlacement*>> options;   // for each ship, the placements that fit it
+};
+
+bool make_known(const Game& g, const Position& p, Known& k) {
+    int n_cells = g.rows() * g.cols();
+    if (static_cast<int>(p.shots.size()) != n_cells || p.sunk_at.size() != static_cast<size_t>(g.nShips())) {return false;}
+    for (int i = 0; i < n_cells; ++i) {
+        if (p.shots[i] == 'o') { k.misses.set(i);}
+        else if (p.shots[i] == 'X') { k.hits.set(i);}
+        else if (p.shots[i] != '.') {return false;}
+    }
+    k.options.assign(g.nShips(), vector<const ShipPlacement*>());
+    for (int s = 0, N = g.nShips(); s < N; ++s) {
+        int sunk = p.sunk_at[s];
+        if (sunk >= n_cells || (sunk >= 0 && !k.hits[sunk])) {return false;}
+        const ShipShape& shape = g.shipShape(s);
+        for (int j = 0, M = shape.placements(); j < M; ++j) {
+            const ShipPlacement& L = shape.placement(j);
+            if ((L.mask & k.misses).any()) {continue;}
+            bool all_hits = (L.mask & ~k.hits).none();
+            if (sunk >= 0 ? all_hits && L.mask[sunk] : !all_hits) { k.options[s].push_back(&L);}
+        }
+    }
+    return true;
+}
+
+/*
+ Counts the layouts by going through the ships one at a time, as place_ships does but trying every placement.
+ Each placement adds the number of layouts below it to each of its cells, so the counts come out
+ without visiting the layouts one by one. Sunk ships, with only a few places to be, go first
+ */
+struct LayoutCounter
+{
+    const Known& k;
+    vector<int> order;
+    vector<size_t> cells_left;      // cells_left[d]: how many cells the ships from order[d] on cover
+    vector<double> counts;
+
+    double count(size_t depth, const CellSet& occupied) {
+        CellSet uncovered = k.hits & ~occupied;
+        if (depth == order.size()) {return uncovered.none() ? 1 : 0;}
+        if (uncovered.count() > cells_left[depth]) {return 0;}
+        double total = 0;
+        const vector<const ShipPlacement*>& options = k.options[order[depth]];
+        for (size_t j = 0, N = options.size(); j < N; ++j) {
+            if ((options[j]->mask & occupied).any()) {continue;}
+            double n = count(depth + 1, occupied | options[j]->mask);
+            if (n == 0) {continue;}
+            for (size_t i = 0, M = options[j]->cells.size(); i < M; ++i) { counts[options[j]->cells[i]] += n;}
+            total += n;
+        }
+        return total;
+    }
+};
+
+// fills probabilities from counts over a number of layouts, leaving the shot cells at 0
+void to_probabilities(const Position& p, const vector<double>& counts, double layouts, vector<double>& probabilities) {
+    probabilities.assign(p.shots.size(), 0.0);
+    if (layouts <= 0) {return;}
+    for (size_t i = 0, N = p.shots.size(); i < N; ++i) {
+        if (p.shots[i] == '.') { probabilities[i] = counts[i] / layouts;}
+    }
+}
+
+
+// counts as read_to left them, plus the ships determine_locations fixed on the board (read_to leaves them out)
+vector<double> with_fixed_ships(const Game& g, const Possibilities_Board& board, const vector<int>& counts, double accepted) {
+    vector<double> total(counts.begin(), counts.end());
+    for (size_t i = 0, N = total.size(); i < N; ++i) {
+        for (int s = 0, M = g.nShips(); s < M; ++s) {
+            if (board.ship_cells(s)[i]) {total[i] = accepted;}
+        }
+    }
+    return total;
+}
+
+class SamplerEstimator : public Estimator
+{
+  public:
+    string name() const override { return "sampler";}
+    long estimate(const Game& g, const Position& p, double budgetMillis, vector<double>& probabilities) override {
+        // the same loop as GoodPlayer::sample_to_data, on one thread, and the same reading as PositionEvaluator
+        probabilities.clear();
+        Possibilities_Board board(g);
+        if (!load_position(g, p, board)) {return 0;}
+        board.determine_locations();
+        vector<int> counts(p.shots.size(), 0);
+        long accepted = 0;
+        auto start = chrono::steady_clock::now();
+        for (long i = 0; i % 20 != 0 || millis_since(start) < budgetMillis; ++i) {
+            if (board.place_ships() && board.is_valid_board()) {
+                board.read_to(counts);
+                ++accepted;
+            }
+            board.unplace_all_ships();
+        }
+        to_probabilities(p, with_fixed_ships(g, board, counts, accepted), accepted, probabilities);
+        return accepted;
+    }
+};
+
+class ExhaustiveEstimator : public Estimator
+{
+  public:
+    string name() const override { return "exhaustive";}
+    long estimate(const Game& g, const Position& p, double budgetMillis, vector<double>& probabilities) override {
+        // Possibilities_Board::sample itself, as GoodPlayer calls it: every layout once, if it finds them all
+        probabilities.clear();
+        Possibilities_Board board(g);
+        if (!load_position(g, p, board)) {return 0;}
+        board.determine_locations();
+        vector<int> counts(p.shots.size(), 0);
+        Sample_Report report;
+        board.sample(counts, 1000000000, budgetMillis, &report);
+        to_probabilities(p, with_fixed_ships(g, board, counts, report.accepted), report.accepted, probabilities);
+        return static_cast<long>(report.exhausted ? report.distinct : report.accepted);
+    }
+};
+
+class RejectionEstimator : public Estimator
+{
+  public:
+    string name() const override { return "rejection";}
+    long estimate(const Game& g, const Position& p, double budgetMillis, vector<double>& probabilities) override {
+        /*
+         each ship at a uniformly random one of the placements that fit it on its own,
+         kept only if the ships don't overlap and cover every hit. Every layout that fits is drawn
+         with the same chance, so the only error is noise, but with many hits most draws are thrown out
+         */
+        probabilities.clear();
+        Known k;
+        if (!make_known(g, p, k)) {return 0;}
+        vector<double> counts(p.shots.size(), 0);
+        long accepted = 0;
+        bool possible = true;
+        for (size_t s = 0, N = k.options.size(); s < N; ++s) { possible = possible && !k.options[s].empty();}
+        auto start = chrono::steady_clock::now();
+        for (long i = 0; possible && (i % 64 != 0 || millis_since(start) < budgetMillis); ++i) {
+            CellSet occupied;
+            bool fits = true;
+            for (size_t s = 0, N = k.options.size(); s < N && fits; ++s) {
+                const ShipPlacement& L = *k.options[s][randInt(static_cast<int>(k.options[s].size()))];
+                fits = (L.mask & occupied).none();
+                occupied |= L.mask;
+            }
+            if (!fits || (k.hits & ~occupied).any()) {continue;}
+            for (size_t j = 0, N = counts.size(); j < N; ++j) {
+                if (occupied[j]) { counts[j] += 1;}
+            }
+            ++accepted;
+        }
+        to_probabilities(p, counts, accepted, probabilities);
+        return accepted;
+    }
+};
+
+class DensityEstimator : public Estimator
+{
+  public:
+    string name() const override { return "density";}
+    long estimate(const Game& g, const Position& p, double, vector<double>& probabilities) override {
+        probabilities.clear();
+        Possibilities_Board board(g);
+        if (!load_position(g, p, board)) {return 0;}
+        board.determine_locations();
+        vector<double> density;
+        board.read_density(density);
+        to_probabilities(p, density, 1, probabilities);
+        return 0;
+    }
+};
+
+}
+
+Estimator* createEstimator(string type) {
+    if (type == "sampler") {return new SamplerEstimator;}
+    if (type == "rejection") {return new RejectionEstimator;}
+    if (type == "density") {return new DensityEstimator;}
+    if (type == "exhaustive") {return new ExhaustiveEstimator;}
+    return nullptr;
+}
+
+bool exact_probabilities(const Game& g, const Position& p, vector<double>& probabilities, double& layouts) {
+    probabilities.clear();
+    layouts = 0;
+    Known k;
+    if (!make_known(g, p, k)) {return false;}
+    LayoutCounter counter = { k, vector<int>(), vector<size_t>(), vector<double>(p.shots.size(), 0) };
+    for (int s = 0, N = g.nShips(); s < N; ++s) {
+        if (p.sunk_at[s] >= 0) { counter.order.push_back(s);}
+    }
+    for (int s = 0, N = g.nShips(); s < N; ++s) {
+        if (p.sunk_at[s] < 0) { counter.order.push_back(s);}
+    }
+    counter.cells_left.assign(counter.order.size() + 1, 0);
+    for (size_t d = counter.order.size(); d-- > 0; ) {
+        counter.cells_left[d] = counter.cells_left[d + 1] + g.shipLength(counter.order[d]);
+    }
+    layouts = counter.count(0, CellSet());
+    to_probabilities(p, counter.counts, layouts, probabilities);
+    return layouts > 0;
+}
+
+Position random_position(const Game& g, int minShots, int maxShots) {
+    int rows = g.rows(), cols = g.cols(), n_cells = rows * cols, n_ships = g.nShips();
+    // a uniformly random layout, the way LayoutCorpus::generate draws one. A big fleet almost never lands without
+    // an overlap that way, so after UNIFORM_TRIES each ship only picks from the places it still fits:
+    // not quite uniform, but it gets there
+    const int UNIFORM_TRIES = 100000;
+    vector<int> ship_at(n_cells, -1);
+    vector<const ShipPlacement*> fits;
+    bool placed = false;
+    for (int tries = 0; !placed; ++tries) {
+        ship_at.assign(n_cells, -1);
+        placed = true;
+        for (int s = 0; s < n_ships && placed; ++s) {
+            const ShipShape& shape = g.shipShape(s);
+            const ShipPlacement* L = &shape.placement(randInt(shape.placements()));
+            if (tries >= UNIFORM_TRIES) {
+                fits.clear();
+                for (int k = 0, K = shape.placements(); k < K; ++k) {
+                    const ShipPlacement& M = shape.placement(k);
+                    bool free = true;
+                    for (size_t i = 0, N = M.cells.size(); i < N && free; ++i) { free = ship_at[M.cells[i]] < 0;}
+                    if (free) { fits.push_back(&M);}
+                }
+                if (fits.empty()) { placed = false; break;}
+                L = fits[randInt(static_cast<int>(fits.size()))];
+            }
+            for (size_t i = 0, N = L->cells.size(); i < N && placed; ++i) { placed = ship_at[L->cells[i]] < 0;}
+            for (size_t i = 0, N = L->cells.size(); i < N && placed; ++i) { ship_at[L->cells[i]] = s;}
+        }
+    }
+
+    Position p;
+    p.rows = rows;
+    p.cols = cols;
+    for (int s = 0; s < n_ships; ++s) { p.ships.push_back(g.shipShape(s).cells(0));}
+    p.shots.assign(n_cells, '.');
+    p.sunk_at.assign(n_ships, -1);
+    vector<int> left(n_ships);
+    for (int s = 0; s < n_ships; ++s) { left[s] = g.shipLength(s);}
+    int afloat = n_ships;
+
+    // three shots in four go next to a hit, when there is one, as a player finishing off a ship would.
+    // The shot count is drawn after the layout, so the positions make_accuracy_corpus draws stay reproducible
+    for (int t = 0, N = minShots + randInt(maxShots - minShots + 1); t < N && afloat > 0; ++t) {
+        vector<int> targets, untried;
+        for (int i = 0; i < n_cells; ++i) {
+            if (p.shots[i] != '.') {continue;}
+            untried.push_back(i);
+            int r = i / cols, c = i % cols;
+            if ((r > 0 && p.shots[i - cols] == 'X') || (r + 1 < rows && p.shots[i + cols] == 'X') ||
+                (c > 0 && p.shots[i - 1] == 'X') || (c + 1 < cols && p.shots[i + 1] == 'X')) { targets.push_back(i);}
+        }
+        if (untried.empty()) {break;}
+        int cell = !targets.empty() && randInt(4) != 0 ? targets[randInt(static_cast<int>(targets.size()))]
+                                                       : untried[randInt(static_cast<int>(untried.size()))];
+        int s = ship_at[cell];
+        if (s < 0) { p.shots[cell] = 'o'; continue;}
+        p.shots[cell] = 'X';
+        if (--left[s] == 0) { p.sunk_at[s] = cell; --afloat;}
+    }
+    return p;
+}
+
+vector<ExactPosition> make_accuracy_corpus(const Game& g, int n, int minShots, int maxShots) {
+    vector<ExactPosition> corpus;
+    while (static_cast<int>(corpus.size()) < n) {
+        ExactPosition e;
+        e.position = random_position(g, minShots, maxShots);
+        bool afloat = false;
+        for (size_t s = 0, N = e.position.sunk_at.size(); s < N; ++s) { afloat = afloat || e.position.sunk_at[s] < 0;}
+        if (afloat && exact_probabilities(g, e.position, e.exact, e.layouts)) { corpus.push_back(e);}
+    }
+    return corpus;
+}
+
+AccuracyScore score_estimator(Estimator& e, const Game& g, const vector<ExactPosition>& corpus, double budgetMillis, int repeats) {
+    AccuracyScore score = { budgetMillis, 0, 0, 0, 0, 0, 0, 0, 0 };
+    double n_cells = 0, agreed = 0, biased = 0;
+    vector<double> estimate, average;
+    for (size_t k = 0, N = corpus.size(); k < N; ++k) {
+        const ExactPosition& x = corpus[k];
+        const string& shots = x.position.shots;
+        double best = 0;
+        for (size_t i = 0, M = shots.size(); i < M; ++i) {
+            if (shots[i] == '.') { best = max(best, x.exact[i]);}
+        }
+        average.assign(shots.size(), 0.0);
+        for (int r = 0; r < repeats; ++r) {
+            score.layouts += e.estimate(g, x.position, budgetMillis, estimate);
+            if (estimate.size() != shots.size()) { estimate.assign(shots.size(), 0.0);}
+            ++score.estimates;
+            int argmax = -1;
+            for (size_t i = 0, M = shots.size(); i < M; ++i) {
+                if (shots[i] != '.') {continue;}
+                double error = fabs(estimate[i] - x.exact[i]);
+                score.meanError += error;
+                score.rmsError += error * error;
+                score.maxError = max(score.maxError, error);
+                average[i] += estimate[i] / repeats;
+                n_cells += 1;
+                if (argmax < 0 || estimate[i] > estimate[argmax]) { argmax = static_cast<int>(i);}
+            }
+            if (argmax >= 0 && x.exact[argmax] >= best - 1e-9) { agreed += 1;}
+            if (argmax >= 0) { score.regret += best - x.exact[argmax];}
+        }
+        for (size_t i = 0, M = shots.size(); i < M; ++i) {
+            if (shots[i] == '.') { biased += fabs(average[i] - x.exact[i]);}
+        }
+    }
+    if (score.estimates == 0 || n_cells == 0) {return score;}
+    score.layouts /= score.estimates;
+    score.meanError /= n_cells;
+    score.rmsError = sqrt(score.rmsError / n_cells);
+    score.argmaxAgreement = agreed / score.estimates;
+    score.regret /= score.estimates;
+    score.bias = biased / (n_cells / repeats);
+    return score;
+}
@@ -0,0 +1,80 @@
+//
+//  Accuracy.h
+//  Battleship
+//
+
+#ifndef ACCURACY_INCLUDED
+#define ACCURACY_INCLUDED
+
+#include "Evaluation.h"
+#include <string>
+#include <vector>
+
+/*
+ How good are the chances GoodPlayer shoots by? On a board small enough, every layout that fits a position
+ can be counted, and that gives the exact chance that each cell is under a ship (every layout that fits being as likely as any other).
+ This measures an estimator against those exact chances, for a fixed amount of time per position,
+ so a faster estimator and a more accurate one can be compared in numbers.
+
+ An Estimator is anything that turns a position (see Evaluation.h) into a chance for every cell:
+     "sampler"     Possibilities_Board, the way GoodPlayer samples: each ship in turn at a random place that still fits
+     "rejection"   uniformly random layouts, thrown out unless they fit the position: unbiased, but most are thrown out
+     "density"     Possibilities_Board::read_density, each ship on its own with no layouts at all: microseconds, whatever the budget
+     "exhaustive"  Possibilities_Board::sample, as GoodPlayer calls it: the sampler, but each layout once when it finds them all
+
+ The sampler's layouts aren't uniform: a ship with few places left to go gets each of them more often than
+ a ship with many, and it doesn't know a ship afloat can't be all hits (it would have been sunk).
+ That is its bias, which more time doesn't fix; score_estimator separates it from the noise that more time does fix
+ by estimating each position several times and comparing the average with the exact answer.
+
+ make_accuracy_corpus builds the positions with random_position: a uniformly random layout and some shots at it,
+ each shot either next to a hit or anywhere, like a player part way through a game.
+ */
+
+class Game;
+
+class Estimator
+{
+  public:
+    virtual ~Estimator() {}
+    virtual std::string name() const = 0;
+    // fills probabilities for p (0 for cells that have been shot) in about budgetMillis; returns the layouts it counted
+    virtual long estimate(const Game& g, const Position& p, double budgetMillis, std::vector<double>& probabilities) = 0;
+};
+
+Estimator* createEstimator(std::string type);   // nullptr for a type it doesn't know
+
+struct ExactPosition
+{
+    Position position;
+    std::vector<double> exact;      // the exact chance for each cell
+    double layouts;                 // how many layouts fit the position
+};
+
+// the exact chances for p by counting every layout that fits it; false if the position doesn't make sense or nothing fits
+bool exact_probabilities(const Game& g, const Position& p, std::vector<double>& probabilities, double& layouts);
+
+// a random layout of g (uniform unless the fleet is too big to draw that way), and minShots to maxShots shots at it
+// (fewer if they sink every ship)
+Position random_position(const Game& g, int minShots, int maxShots);
+
+// n positions of g, each with minShots to maxShots shots and at least one ship afloat, solved exactly
+std::vector<ExactPosition> make_accuracy_corpus(const Game& g, int n, int minShots, int maxShots);
+
+struct AccuracyScore
+{
+    double budgetMillis;
+    long estimates;             // positions times repeats
+    double layouts;             // counted per estimate, on average
+    double meanError;           // |estimate - exact| over the unshot cells of every estimate
+    double rmsError;
+    double maxError;            // the worst cell of any estimate
+    double argmaxAgreement;     // the fraction of estimates whose best cell is one of the exact best cells
+    double regret;              // the exact chance of a hit given up by shooting the estimate's best cell, on average
+    double bias;                // |average of the repeats - exact| over the unshot cells (includes a little noise)
+};
+
+AccuracyScore score_estimator(Estimator& e, const Game& g, const std::vector<ExactPosition>& corpus,
+                              double budgetMillis, int repeats);
+
+#endif // ACCURACY_INCLUDED
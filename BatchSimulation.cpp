@@ -0,0 +1,406 @@
+//
+//  BatchSimulation.cpp
+//  Battleship
+//
+
+#include "BatchSimulation.h"
+#include "Corpus.h"
+
+using namespace std;
+
+static_assert(MAX_SIM_SHIPS <= 16, "alive keeps one bit per ship in a uint16_t");
+static_assert(MAXCOLS < 64, "shifting a board by a row must stay within one word");
+
+BatchSimulation::BatchSimulation(const SimulationFleet& f, size_t batchSize)
+ : fleet(f), n(batchSize), slots((batchSize + AIM_BLOCK - 1) / AIM_BLOCK * AIM_BLOCK),
+   base_seed(0), to_move(0), finished(0), wins_for_first(0), winner_turns(0),
+   winners(slots, IDLE), rng(slots, 1), plans(slots, HUNT), targets(slots, -1), unshot(slots, 0), afloat_before(slots, 0) {
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        board_mask[w] = odd_mask[w] = not_first_column[w] = not_last_column[w] = 0;
+    }
+    for (int i = 0; i < f.rows*f.cols; ++i) {
+        uint64_t bit = uint64_t(1) << (i % 64);
+        board_mask[i / 64] |= bit;
+        if ((i / f.cols + i % f.cols) % 2 == 1) {odd_mask[i / 64] |= bit;}
+        if (i % f.cols != 0)                     {not_first_column[i / 64] |= bit;}
+        if (i % f.cols != f.cols - 1)            {not_last_column[i / 64] |= bit;}
+    }
+    for (int w = 0; w < CELL_WORDS; ++w) { aims[w].assign(slots, 0);}
+    for (int side = 0; side < 2; ++side) {
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            ships[side][w].assign(slots, 0);
+            shots[side][w].assign(slots, 0);
+            resolved[side][w].assign(slots, 0);
+            for (int s = 0; s < f.n_ships; ++s) { ship_masks[side][s][w].assign(slots, 0);}
+        }
+        alive[side].assign(slots, 0);
+        turns_taken[side].assign(slots, 0);
+    }
+    strategies[0] = strategies[1] = SIM_HUNT;
+    layouts[0] = layouts[1] = nullptr;
+}
+
+uint32_t BatchSimulation::next_random(size_t game) {
+    // the same xorshift64* as CompactGame, one state per game
+    uint64_t& x = rng[game];
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    return static_cast<uint32_t>((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+
+//*********************************************************************
+//  Layouts
+//*********************************************************************
+
+bool BatchSimulation::add_ship(Words taken, Words mask, int shipId, int r, int c, bool vertical) const {
+    // adds the ship to a layout being built if it fits on the board without overlapping another, changing nothing otherwise
+    int cells[MAXROWS > MAXCOLS ? MAXROWS : MAXCOLS];
+    for (int i = 0; i < fleet.lengths[shipId]; ++i) {
+        int rr = r + (vertical ? i : 0), cc = c + (vertical ? 0 : i);
+        if (rr < 0 || cc < 0 || rr >= fleet.rows || cc >= fleet.cols) {return false;}
+        cells[i] = rr*fleet.cols + cc;
+        if (taken[cells[i] / 64] >> (cells[i] % 64) & 1) {return false;}
+    }
+    for (int w = 0; w < CELL_WORDS; ++w) { mask[w] = 0;}
+    for (int i = 0; i < fleet.lengths[shipId]; ++i) {
+        uint64_t bit = uint64_t(1) << (cells[i] % 64);
+        taken[cells[i] / 64] |= bit;
+        mask[cells[i] / 64] |= bit;
+    }
+    return true;
+}
+
+void BatchSimulation::store_layout(int side, size_t game, const Words taken, const Words masks[]) {
+    // the layout is built in local words and written out once, since a game's words are far apart in memory
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        ships[side][w][game] = taken[w];
+        for (int s = 0; s < fleet.n_ships; ++s) { ship_masks[side][s][w][game] = masks[s][w];}
+    }
+    alive[side][game] = static_cast<uint16_t>((1u << fleet.n_ships) - 1);
+}
+
+void BatchSimulation::place_uniform(int side, size_t game) {
+    // uniformly random layout: any ship that doesn't fit throws the whole layout out
+    Words taken, masks[MAX_SIM_SHIPS];
+    bool placed = false;
+    while (!placed) {
+        for (int w = 0; w < CELL_WORDS; ++w) { taken[w] = 0;}
+        placed = true;
+        for (int s = 0; s < fleet.n_ships && placed; ++s) {
+            int r = next_random(game) % fleet.rows;
+            int c = next_random(game) % fleet.cols;
+            placed = add_ship(taken, masks[s], s, r, c, next_random(game) % 2);
+        }
+    }
+    store_layout(side, game, taken, masks);
+}
+
+void BatchSimulation::use_layouts(const LayoutCorpus* corpus, int side) {
+    // nullptr goes back to uniformly random layouts
+    layouts[side] = corpus;
+}
+
+
+//*********************************************************************
+//  Targeting
+//*********************************************************************
+
+// the targeting masks of one block of games: word w of game j is at [w][j]
+typedef uint64_t BlockWords[CELL_WORDS][AIM_BLOCK];
+
+static inline void shift_up(const BlockWords m, int k, BlockWords out) {
+    // moves every cell k places toward higher cell numbers, 0 < k < 64; may spill past the board
+    for (int w = CELL_WORDS - 1; w > 0; --w) {
+        for (int j = 0; j < AIM_BLOCK; ++j) { out[w][j] = (m[w][j] << k) | (m[w-1][j] >> (64 - k));}
+    }
+    for (int j = 0; j < AIM_BLOCK; ++j) { out[0][j] = m[0][j] << k;}
+}
+
+static inline void shift_down(const BlockWords m, int k, BlockWords out) {
+    // moves every cell k places toward lower cell numbers, 0 < k < 64
+    for (int w = 0; w + 1 < CELL_WORDS; ++w) {
+        for (int j = 0; j < AIM_BLOCK; ++j) { out[w][j] = (m[w][j] >> k) | (m[w+1][j] << (64 - k));}
+    }
+    for (int j = 0; j < AIM_BLOCK; ++j) { out[CELL_WORDS-1][j] = m[CELL_WORDS-1][j] >> k;}
+}
+
+int BatchSimulation::random_bit(const Words m, size_t game) {
+    int total = 0;
+    for (int w = 0; w < CELL_WORDS; ++w) { total += __builtin_popcountll(m[w]);}
+    if (total == 0) {return -1;}
+    int k = next_random(game) % total;
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        int count = __builtin_popcountll(m[w]);
+        if (k >= count) {k -= count; continue;}
+        // halve the word until the k-th set bit is found: it's in the low half, or it's the (k - low)-th of the high half.
+        // Which half is a coin flip, so it's picked with arithmetic rather than a branch
+        uint64_t bits = m[w];
+        int at = 0;
+        for (int width = 32; width > 0; width /= 2) {
+            int low = __builtin_popcountll(bits & ((uint64_t(1) << width) - 1));
+            int high = k >= low;
+            k -= high * low;
+            bits >>= high * width;
+            at += high * width;
+        }
+        return 64*w + at;
+    }
+    return -1;
+}
+
+int BatchSimulation::lowest_bit(const Words m) {
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        if (m[w] != 0) {return 64*w + __builtin_ctzll(m[w]);}
+    }
+    return -1;
+}
+
+void BatchSimulation::aim(int side) {
+    /*
+     SIM_HUNT's choice for every game of the batch at once, made the way CompactGame::hunt_target makes it.
+     With u the unexplained hits, the first hit of u in scan order with an untried neighbor is the one we work on.
+     Its neighbor in direction d (north, east, south, west, in that order) is next[d]: we continue a line through the hit
+     in the first direction whose next[d] is untried while the opposite neighbor is in u, or else shoot its first untried neighbor.
+     That hit is left in aims, and the plan says which of the eight moves from it to make (LINE + d or NEIGHBOR + d).
+     A game with no such hit gets the plan HUNT and its untried cells of odd parity instead
+     (any untried cell once those run out), and choose_target picks one of them at random.
+
+     The games go AIM_BLOCK at a time, and every loop below runs over the games of a block with the same
+     branch free bit operations, a fixed number of times, so each one turns into vector instructions
+     */
+    int board = 1 - side;
+    int cols = fleet.cols;
+    for (size_t first = 0; first < slots; first += AIM_BLOCK) {
+        BlockWords u, untried;
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            const uint64_t* shot_words = shots[board][w].data() + first;
+            const uint64_t* ship_words = ships[board][w].data() + first;
+            const uint64_t* resolved_words = resolved[side][w].data() + first;
+            uint64_t cells = board_mask[w];
+            for (int j = 0; j < AIM_BLOCK; ++j) {
+                u[w][j] = shot_words[j] & ship_words[j] & ~resolved_words[j];
+                untried[w][j] = cells & ~shot_words[j];
+            }
+        }
+
+        // the hits with an untried neighbor, and the lowest of them alone
+        BlockWords north, east, south, west, hit;
+        shift_up(untried, cols, north);
+        shift_down(untried, 1, east);
+        shift_down(untried, cols, south);
+        shift_up(untried, 1, west);
+        uint64_t none_yet[AIM_BLOCK];
+        for (int j = 0; j < AIM_BLOCK; ++j) { none_yet[j] = ~uint64_t(0);}
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            uint64_t cells = board_mask[w], left = not_first_column[w], right = not_last_column[w];
+            for (int j = 0; j < AIM_BLOCK; ++j) {
+                uint64_t workable = u[w][j] & ((north[w][j] & cells) | (east[w][j] & right) | south[w][j] | (west[w][j] & left));
+                hit[w][j] = workable & (0 - workable) & none_yet[j];
+                none_yet[j] &= workable != 0 ? 0 : ~uint64_t(0);
+            }
+        }
+
+        // for each direction, whether the hit's neighbor that way is untried, and whether it is in u
+        BlockWords next[4];
+        shift_down(hit, cols, next[0]);
+        shift_up(hit, 1, next[1]);
+        shift_up(hit, cols, next[2]);
+        shift_down(hit, 1, next[3]);
+        uint64_t open[4][AIM_BLOCK], hit_too[4][AIM_BLOCK];
+        for (int d = 0; d < 4; ++d) {
+            for (int j = 0; j < AIM_BLOCK; ++j) { open[d][j] = hit_too[d][j] = 0;}
+            for (int w = 0; w < CELL_WORDS; ++w) {
+                uint64_t keep = d == 1 ? not_first_column[w] : d == 3 ? not_last_column[w] : board_mask[w];
+                for (int j = 0; j < AIM_BLOCK; ++j) {
+                    open[d][j] |= next[d][w][j] & keep & untried[w][j];
+                    hit_too[d][j] |= next[d][w][j] & keep & u[w][j];
+                }
+            }
+        }
+
+        // the first move that works, lines before plain neighbors, so go through them backwards
+        uint64_t choice[AIM_BLOCK];
+        for (int j = 0; j < AIM_BLOCK; ++j) { choice[j] = HUNT;}
+        for (int d = 3; d >= 0; --d) {
+            for (int j = 0; j < AIM_BLOCK; ++j) { choice[j] = open[d][j] != 0 ? NEIGHBOR + d : choice[j];}
+        }
+        for (int d = 3; d >= 0; --d) {
+            const uint64_t* behind = hit_too[(d + 2) % 4];
+            for (int j = 0; j < AIM_BLOCK; ++j) { choice[j] = (open[d][j] != 0) & (behind[j] != 0) ? LINE + d : choice[j];}
+        }
+
+        uint64_t parity_only[AIM_BLOCK];
+        for (int j = 0; j < AIM_BLOCK; ++j) { parity_only[j] = 0;}
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            uint64_t odd = odd_mask[w];
+            for (int j = 0; j < AIM_BLOCK; ++j) { parity_only[j] |= untried[w][j] & odd;}
+        }
+        for (int j = 0; j < AIM_BLOCK; ++j) { parity_only[j] = parity_only[j] != 0 ? ~uint64_t(0) : 0;}
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            uint64_t* aim_words = aims[w].data() + first;
+            uint64_t odd = odd_mask[w];
+            for (int j = 0; j < AIM_BLOCK; ++j) {
+                uint64_t hunting = choice[j] == HUNT ? ~uint64_t(0) : 0;
+                aim_words[j] = (hit[w][j] & ~hunting) | (untried[w][j] & (odd | ~parity_only[j]) & hunting);
+            }
+        }
+        uint8_t* plan = plans.data() + first;
+        for (int j = 0; j < AIM_BLOCK; ++j) { plan[j] = static_cast<uint8_t>(choice[j]);}
+    }
+}
+
+int BatchSimulation::choose_target(int side, size_t game) {
+    // the last, per game part of choosing: only hunting draws a random number, as in CompactGame
+    if (strategies[side] == SIM_SWEEP) {
+        return fleet.rows*fleet.cols - 1 - turns_taken[side][game];
+    }
+    Words candidates;
+    for (int w = 0; w < CELL_WORDS; ++w) { candidates[w] = aims[w][game];}
+    if (plans[game] == HUNT) {return random_bit(candidates, game);}
+    const int offsets[4] = {-fleet.cols, 1, fleet.cols, -1};
+    return lowest_bit(candidates) + offsets[plans[game] % 4];
+}
+
+void BatchSimulation::resolve_sink(int side, size_t game, int cell, int length) {
+    // the same guess as CompactGame::resolve_sink: a straight run of unexplained hits through the sinking cell
+    int board = 1 - side;
+    Words u;
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        u[w] = shots[board][w][game] & ships[board][w][game] & ~resolved[side][w][game];
+    }
+    int r = cell / fleet.cols, c = cell % fleet.cols;
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int offset = 0; offset < length; ++offset) {
+            int r0 = r - (vertical ? offset : 0);
+            int c0 = c - (vertical ? 0 : offset);
+            bool fits = r0 >= 0 && c0 >= 0;
+            for (int i = 0; fits && i < length; ++i) {
+                int rr = r0 + (vertical ? i : 0), cc = c0 + (vertical ? 0 : i);
+                int k = rr*fleet.cols + cc;
+                fits = rr < fleet.rows && cc < fleet.cols && (u[k / 64] >> (k % 64) & 1);
+            }
+            if (!fits) {continue;}
+            for (int i = 0; i < length; ++i) {
+                int k = (r0 + (vertical ? i : 0))*fleet.cols + c0 + (vertical ? 0 : i);
+                resolved[side][k / 64][game] |= uint64_t(1) << (k % 64);
+            }
+            return;
+        }
+    }
+    resolved[side][cell / 64][game] |= uint64_t(1) << (cell % 64);
+}
+
+
+//*********************************************************************
+//  Playing
+//*********************************************************************
+
+void BatchSimulation::start_game(size_t slot, long game) {
+    rng[slot] = (base_seed + game) * 0x9E3779B97F4A7C15ULL + 1;
+    winners[slot] = PLAYING;
+    for (int side = 0; side < 2; ++side) {
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            shots[side][w][slot] = 0;
+            resolved[side][w][slot] = 0;
+        }
+        turns_taken[side][slot] = 0;
+        const LayoutCorpus* corpus = layouts[side];
+        if (corpus == nullptr || corpus->size() == 0) {
+            place_uniform(side, slot);
+            continue;
+        }
+        long layout = game % corpus->size();
+        Words taken = {}, masks[MAX_SIM_SHIPS] = {};
+        for (int s = 0; s < fleet.n_ships; ++s) {
+            Point p = corpus->top_or_left(layout, s);
+            add_ship(taken, masks[s], s, p.r, p.c, corpus->orientation(layout, s) == VERTICAL);
+        }
+        store_layout(side, slot, taken, masks);
+    }
+}
+
+bool BatchSimulation::step() {
+    /*
+     one turn for every unfinished game, in passes over the batch:
+     aim (vectorized), pick each game's cell from its aim (per game), mark shots (vectorized),
+     check every ship for a sink (vectorized)
+     and finally put sinks down to the right hits for the few games that had one.
+     Returns false once every game is over
+     */
+    int side = to_move;
+    int board = 1 - side;
+    bool any_active = false;
+    if (strategies[side] == SIM_HUNT) {aim(side);}
+    for (size_t i = 0; i < slots; ++i) {
+        targets[i] = winners[i] != PLAYING ? -1 : choose_target(side, i);
+        any_active = any_active || targets[i] >= 0;
+    }
+    if (!any_active) {to_move = 0; return false;}  // nothing in play, so the next game can start right away
+
+    for (int w = 0; w < CELL_WORDS; ++w) {
+        uint64_t* shot_words = shots[board][w].data();
+        const int* t = targets.data();
+        for (size_t i = 0; i < slots; ++i) {
+            // finished games have target -1, whose word number never matches
+            uint64_t bit = (static_cast<unsigned>(t[i]) >> 6) == static_cast<unsigned>(w) ? uint64_t(1) << (t[i] & 63) : 0;
+            shot_words[i] |= bit;
+        }
+    }
+    uint16_t* turn_counts = turns_taken[side].data();
+    for (size_t i = 0; i < slots; ++i) { turn_counts[i] += targets[i] >= 0;}
+
+    uint16_t* afloat = alive[board].data();
+    uint64_t* live = unshot.data();
+    for (size_t i = 0; i < slots; ++i) { afloat_before[i] = afloat[i];}
+    for (int s = 0; s < fleet.n_ships; ++s) {
+        for (size_t i = 0; i < slots; ++i) { live[i] = 0;}
+        for (int w = 0; w < CELL_WORDS; ++w) {
+            const uint64_t* mask = ship_masks[board][s][w].data();
+            const uint64_t* shot_words = shots[board][w].data();
+            for (size_t i = 0; i < slots; ++i) { live[i] |= mask[i] & ~shot_words[i];}
+        }
+        uint16_t sunk_mask = static_cast<uint16_t>(~(1u << s));
+        for (size_t i = 0; i < slots; ++i) { afloat[i] &= live[i] != 0 ? 0xFFFF : sunk_mask;}
+    }
+
+    for (size_t i = 0; i < slots; ++i) {
+        uint16_t sunk = afloat_before[i] & ~afloat[i];
+        if (sunk == 0) {continue;}
+        resolve_sink(side, i, targets[i], fleet.lengths[__builtin_ctz(sunk)]);
+        if (afloat[i] == 0) {
+            winners[i] = static_cast<int8_t>(side);
+            ++finished;
+            wins_for_first += side == 0;
+            winner_turns += turn_counts[i];
+        }
+    }
+    to_move = board;
+    return true;
+}
+
+long BatchSimulation::run(SimStrategy first, SimStrategy second, uint64_t seed, long nGames) {
+    /*
+     plays games seed, seed + 1, ..., seed + nGames - 1 and returns how many the first side won.
+     Finished slots are refilled at the start of a turn for side 0, until every game has been started
+     */
+    strategies[0] = first;
+    strategies[1] = second;
+    base_seed = seed;
+    to_move = 0;
+    finished = wins_for_first = winner_turns = 0;
+    for (size_t i = 0; i < n; ++i) { winners[i] = IDLE;}
+
+    long next_game = 0;
+    bool playing = true;
+    while (playing) {
+        if (to_move == 0) {
+            for (size_t i = 0; i < n && next_game < nGames; ++i) {
+                if (winners[i] != PLAYING) { start_game(i, next_game++);}
+            }
+        }
+        playing = step() || next_game < nGames;
+    }
+    return wins_for_first;
+}
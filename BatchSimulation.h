@@ -0,0 +1,105 @@
+//
+//  BatchSimulation.h
+//  Battleship
+//
+
+#ifndef BATCHSIMULATION_INCLUDED
+#define BATCHSIMULATION_INCLUDED
+
+#include "Simulation.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ BatchSimulation plays a whole batch of games in lockstep: every game takes its first turn,
+ then every game takes its second turn, and so on. Since every game starts with side 0 and the sides alternate,
+ the side to move is the same for the whole batch at every step.
+
+ Rather than an array of CompactGames, everything is kept as a structure of arrays:
+ a board is CELL_WORDS 64 bit words, and word w of every game's board sits in one array, indexed by game.
+ Marking shots, checking for hits, and checking every ship for a sink are then the same few bit operations
+ repeated across consecutive games, which the compiler turns into vector instructions.
+ Each ship keeps its own mask, so a sink check is "does any of this ship's cells remain unshot",
+ with no per-cell ship lookup at all.
+
+ SIM_SWEEP just counts down the cells. SIM_HUNT makes exactly the choice CompactGame::hunt_target makes,
+ worked out for the whole batch at once from shifts of the hit and untried masks (see aim()),
+ which leaves each game only the last step: the hit's neighbor to shoot, or a random draw while hunting.
+ Both engines draw from the same xorshift, seeded the same way,
+ so game k of a run here is the same game as game k of simulate_games.
+
+ With g++, aim()'s fixed size blocks are vectorized at -O2, but the loops over the whole batch in step() need -O3;
+ at -O2 the lockstep engine is only a little faster than the CompactGame loop.
+
+ Games don't all last the same number of turns, so a batch isn't run until its slowest game ends:
+ whenever a game finishes, its slot is restarted with the next game of the run (on a turn where side 0 moves,
+ so every game still starts with side 0), and the batch stays full until the run is nearly done.
+
+ Layouts are uniformly random by default. To evaluate a placement generator,
+ write its layouts to a LayoutCorpus and hand it to use_layouts(); game k then uses layout k for that side.
+ */
+
+class LayoutCorpus;
+
+const int CELL_WORDS = (MAXCELLS + 63) / 64;
+const int AIM_BLOCK = 64;       // games whose targets are worked out together
+
+class BatchSimulation
+{
+  public:
+    BatchSimulation(const SimulationFleet& f, size_t batchSize);
+    void use_layouts(const LayoutCorpus* corpus, int side);
+    long run(SimStrategy first, SimStrategy second, uint64_t seed, long nGames);
+    size_t size() const { return n;}
+    long games_finished() const { return finished;}
+    long first_wins() const { return wins_for_first;}
+    double mean_turns_to_win() const { return finished > 0 ? static_cast<double>(winner_turns) / finished : 0;}
+  private:
+    typedef uint64_t Words[CELL_WORDS];
+    enum { PLAYING = -1, IDLE = 2 }; // winners[] also holds 0 or 1 for a finished game
+    enum { LINE = 0, NEIGHBOR = 4, HUNT = 8 }; // plans[]: LINE + d, NEIGHBOR + d for a direction d, or HUNT
+    void start_game(size_t slot, long game);
+    bool step();
+    bool add_ship(Words taken, Words mask, int shipId, int r, int c, bool vertical) const;
+    void store_layout(int side, size_t game, const Words taken, const Words masks[]);
+    void place_uniform(int side, size_t game);
+    int choose_target(int side, size_t game);
+    void aim(int side);
+    int random_bit(const Words m, size_t game);
+    static int lowest_bit(const Words m);
+    void resolve_sink(int side, size_t game, int cell, int length);
+    uint32_t next_random(size_t game);
+
+    SimulationFleet fleet;
+    size_t n;
+    size_t slots;                               // n rounded up to whole AIM_BLOCKs, the extra games never play
+    SimStrategy strategies[2];
+    const LayoutCorpus* layouts[2];
+    uint64_t base_seed;
+    int to_move;
+    long finished;
+    long wins_for_first;
+    long winner_turns;
+    Words board_mask;                           // every cell on the board
+    Words odd_mask;                             // cells with (r + c) odd
+    Words not_first_column;
+    Words not_last_column;
+
+    // word w of game i is at [w][i]
+    std::vector<uint64_t> ships[2][CELL_WORDS];
+    std::vector<uint64_t> shots[2][CELL_WORDS];
+    std::vector<uint64_t> resolved[2][CELL_WORDS];
+    std::vector<uint64_t> ship_masks[2][MAX_SIM_SHIPS][CELL_WORDS];
+    std::vector<uint16_t> alive[2];              // bit s is set while ship s is afloat
+    std::vector<uint16_t> turns_taken[2];
+    std::vector<int8_t> winners;
+    std::vector<uint64_t> rng;
+    std::vector<uint8_t> plans;                 // scratch: what choose_target does with aims
+    std::vector<uint64_t> aims[CELL_WORDS];    // scratch: the hit to work on, or the cells to draw a target from
+    std::vector<int> targets;                   // scratch: this step's target for every game, -1 if finished
+    std::vector<uint64_t> unshot;               // scratch: a ship's unshot cells, folded into one word per game
+    std::vector<uint16_t> afloat_before;        // scratch: alive at the start of the step
+};
+
+#endif // BATCHSIMULATION_INCLUDED
@@ -1,5 +1,6 @@
 #include "Board.h"
 #include "Game.h"
+#include "ShipShape.h"
 #include "globals.h"
 #include <iostream>
 #include <vector>
@@ -21,28 +22,39 @@ class BoardImpl
     void clear();
     void block();
     void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool placeShip(Point topOrLeft, int shipId, int orientation);
+    bool unplaceShip(Point topOrLeft, int shipId, int orientation);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
+    int attackSalvo(const vector<Point>& shots, vector<ShotResult>& results);
+    bool makeAttack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    bool unmakeAttack();
 
     // functions used by possibilities_boards
     void update(Point p, char c);
     void read_to(vector<int>& data);
     
   private:
+    bool resolve_attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    struct Undo {
+        int cell;
+        char was;       // what the cell held before the attack
+    };
     const Game& m_game;
+    const Fleet& m_fleet;   // the ships, looked up without going through the game (see Game.h)
     vector<char> board;
+    vector<Undo> undo_stack;
 };
 
-BoardImpl::BoardImpl(const Game& g) : m_game(g), board(g.rows()*g.cols(), '.') {
+BoardImpl::BoardImpl(const Game& g) : m_game(g), m_fleet(g.fleet()), board(g.rows()*g.cols(), '.') {
 }
 
 void BoardImpl::clear() {
     for (size_t i = 0, N = board.size(); i < N; ++i) {
         board[i] = '.';
     }
+    undo_stack.clear();
 }
 
 void BoardImpl::block() {
@@ -58,73 +70,37 @@ void BoardImpl::unblock() {
     }
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir) {
+bool BoardImpl::placeShip(Point topOrLeft, int shipId, int orientation) {
     
-    if (shipId >= m_game.nShips())                                          { return false;} // invalid shipId
-    if (search(m_game.shipSymbol(shipId), board))                           { return false;} // ship already on the board
+    if (shipId < 0 || shipId >= m_fleet.nShips)                             { return false;} // invalid shipId
+    char symbol = m_fleet.symbols[shipId];
+    if (search(symbol, board))                                              { return false;} // ship already on the board
 
-    size_t start = m_game.cols() * topOrLeft.r + topOrLeft.c;
+    // the ship's shape already knows every cell of every placement that stays on the board
+    const ShipPlacement* L = m_fleet.shapes[shipId]->find(topOrLeft, orientation);
+    if (L == nullptr)                                                       { return false;} // ship goes off the board
     
     // separate checking and changing loops so don't have to erase upon failure
-    if (dir == HORIZONTAL) {
-        
-        // loop to check
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            // we are at the end of a row & have more to go
-            if ( (((start + i + 1) % m_game.cols()) == 0) && (i+1 < N))     { return false;} // ship goes of end of row
-            if ( board[start + i] != '.')                                   { return false;} // ship runs over something
-        }
-        
-        // loop to change
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            board[start + i] = m_game.shipSymbol(shipId);
-        }
-    }
-    
-    else {
-        // differences: indexing is more complicated, but going off end is easy to check
-        
-        // loop to check
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            if (start + m_game.cols()*i > board.size())                     { return false;} // ship goes of end of column
-            if ( board[start + m_game.cols()*i] != '.')                     { return false;} // ship runs over something
-        }
-        
-        // loop to change
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            board[start + m_game.cols()*i] = m_game.shipSymbol(shipId);
-        }
+    for (size_t i = 0, N = L->cells.size(); i < N; ++i) {
+        if (board[L->cells[i]] != '.')                                      { return false;} // ship runs over something
     }
+    for (size_t i = 0, N = L->cells.size(); i < N; ++i) { board[L->cells[i]] = symbol;}
     return true;
 }
 
 
-
-
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir) {
+bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, int orientation) {
     
-    if (shipId >= m_game.nShips())                                            { return false;} // invalid shipId
-    size_t start = m_game.cols() * topOrLeft.r + topOrLeft.c;
-    // separate checking and changing loops so don't have to reinput upon failure
-    if (dir == HORIZONTAL) {
-        
-        // loop to check
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            if ( board[start + i] != m_game.shipSymbol(shipId))               { return false;} // incomplete ship
-        }
-        // loop to change
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) { board[start + i] = '.';}
-    }
+    if (shipId < 0 || shipId >= m_fleet.nShips)                             { return false;} // invalid shipId
+    const ShipPlacement* L = m_fleet.shapes[shipId]->find(topOrLeft, orientation);
+    if (L == nullptr)                                                       { return false;} // no such placement
     
-    else {
-
-        // loop to check
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) {
-            if ( board[start + m_game.cols()*i] != m_game.shipSymbol(shipId)) { return false;} // incomplete ship
-        }
-        // loop to change
-        for(size_t i = 0, N = m_game.shipLength(shipId); i < N; ++i) { board[start + m_game.cols()*i] = '.';}
+    // separate checking and changing loops so don't have to reinput upon failure
+    char symbol = m_fleet.symbols[shipId];
+    for (size_t i = 0, N = L->cells.size(); i < N; ++i) {
+        if (board[L->cells[i]] != symbol)                                   { return false;} // incomplete ship
     }
+    for (size_t i = 0, N = L->cells.size(); i < N; ++i) { board[L->cells[i]] = '.';}
     return true;
 }
 
@@ -156,13 +132,21 @@ void BoardImpl::display(bool shotsOnly) const {
 }
 
 bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) {
+    if (!resolve_attack(p, shotHit, shipDestroyed, shipId)) {return false;}
+    if (shotHit) {
+        cout << "The attack hit a ship!" << endl;
+        if (shipDestroyed) {cout << "The attack sank the " << m_game.shipName(shipId) << "!" << endl;}
+    }
+    return true;
+}
+
+bool BoardImpl::resolve_attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) {
     if (p.r >= m_game.rows() || p.c >= m_game.cols() || p.r < 0 || p.c < 0)                 {return false;}
     if (board[m_game.cols() * p.r + p.c] == 'o' || board[m_game.cols() * p.r + p.c] == 'X') {return false;}
                                                       
     
     if (board[m_game.cols() * p.r + p.c] != '.') {
         // hit an undamaged part of a ship
-        cout << "The attack hit a ship!" << endl;
         shotHit = true;
         char hit_ship_symbol = board[m_game.cols() * p.r + p.c];
         board[m_game.cols() * p.r + p.c] = 'X';
@@ -172,12 +156,7 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
             shipDestroyed = true;
             
             // finding the correct shipId
-            for (size_t i = 0, N = m_game.nShips(); i < N; ++i) {
-                if (hit_ship_symbol == m_game.shipSymbol(static_cast<int>(i))) {
-                    shipId = static_cast<int>(i);
-                }
-            }
-            cout << "The attack sank the " << m_game.shipName(shipId) << "!" << endl;
+            shipId = m_fleet.shipId(hit_ship_symbol);
         }
         else {
             shipDestroyed = false;
@@ -191,6 +170,38 @@ bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     return true;
 }
 
+int BoardImpl::attackSalvo(const vector<Point>& shots, vector<ShotResult>& results) {
+    // the shots land one after another, so a ship can be sunk by the last two shots of the same salvo
+    int valid = 0;
+    results.resize(shots.size());
+    for (size_t i = 0, N = shots.size(); i < N; ++i) {
+        ShotResult& r = results[i];
+        r.p = shots[i];
+        r.shotHit = r.shipDestroyed = false;
+        r.shipId = -1;
+        r.validShot = attack(shots[i], r.shotHit, r.shipDestroyed, r.shipId);
+        if (r.validShot) {++valid;}
+    }
+    return valid;
+}
+
+bool BoardImpl::makeAttack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) {
+    // an attack only ever changes the one cell, so that cell's old contents are all it takes to undo it
+    int cell = m_game.cols() * p.r + p.c;
+    char was = m_game.isValid(p) ? board[cell] : '.';
+    if (!resolve_attack(p, shotHit, shipDestroyed, shipId)) {return false;}
+    Undo u = {cell, was};
+    undo_stack.push_back(u);
+    return true;
+}
+
+bool BoardImpl::unmakeAttack() {
+    if (undo_stack.empty()) {return false;}
+    board[undo_stack.back().cell] = undo_stack.back().was;
+    undo_stack.pop_back();
+    return true;
+}
+
 bool BoardImpl::allShipsDestroyed() const {
     for (size_t i = 0, N = board.size(); i < N; ++i) {
         if (!(board[i] == 'o' || board[i] == '.' || board[i] == 'X')) {return false;}
@@ -231,14 +242,14 @@ void Board::unblock()
     return m_impl->unblock();
 }
 
-bool Board::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool Board::placeShip(Point topOrLeft, int shipId, int orientation)
 {
-    return m_impl->placeShip(topOrLeft, shipId, dir);
+    return m_impl->placeShip(topOrLeft, shipId, orientation);
 }
 
-bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool Board::unplaceShip(Point topOrLeft, int shipId, int orientation)
 {
-    return m_impl->unplaceShip(topOrLeft, shipId, dir);
+    return m_impl->unplaceShip(topOrLeft, shipId, orientation);
 }
 
 void Board::display(bool shotsOnly) const
@@ -256,9 +267,17 @@ bool Board::allShipsDestroyed() const
     return m_impl->allShipsDestroyed();
 }
 
+int Board::attackSalvo(const vector<Point>& shots, vector<ShotResult>& results)
+{
+    return m_impl->attackSalvo(shots, results);
+}
 
+bool Board::makeAttack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    return m_impl->makeAttack(p, shotHit, shipDestroyed, shipId);
+}
 
-
-
-
-
+bool Board::unmakeAttack()
+{
+    return m_impl->unmakeAttack();
+}
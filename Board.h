@@ -2,6 +2,7 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <vector>
 
 class Game;
 class BoardImpl;
@@ -14,11 +15,18 @@ class Board
     void clear();
     void block();
     void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool placeShip(Point topOrLeft, int shipId, int orientation);
+    bool unplaceShip(Point topOrLeft, int shipId, int orientation);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
+      // Every shot of a salvo in turn, a result for each; returns how many were valid.
+      // A cell repeated within the salvo counts as already attacked.
+    int attackSalvo(const std::vector<Point>& shots, std::vector<ShotResult>& results);
+      // A quiet attack that can be taken back, for players looking ahead;
+      // unmakeAttack undoes the most recent makeAttack still standing.
+    bool makeAttack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    bool unmakeAttack();
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
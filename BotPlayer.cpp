@@ -0,0 +1,300 @@
+//
+//  BotPlayer.cpp
+//  Battleship
+//
+
+#include "BotPlayer.h"
+#include "BotProtocol.h"
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "ShipShape.h"
+#include "LegalMoves.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <csignal>
+#include <sys/wait.h>
+
+using namespace std;
+
+class BotPlayer : public Player
+{
+  public:
+    BotPlayer(string path, string nm, const Game& g);
+    ~BotPlayer();
+    bool connected() const { return channel != nullptr;}
+    bool placeShips(Board& b) override;
+    Point recommendAttack() override;
+    void requestAttack() override;
+    bool pollAttack(Point& p) override;
+    void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId) override;
+    void recordAttackByOpponent(Point p) override;
+    double ping(long n);
+    BotTiming timing() const;
+  private:
+    bool send(const BotMessage& m);
+    bool receive(BotMessage& m, int expectedType, int otherType = -1);
+    bool alive();
+    void disconnect();
+    void time_round_trip(chrono::steady_clock::time_point start);
+    bool accepted(Point p);
+    BotChannel* channel;
+    pid_t bot;
+    LegalMoves moves;       // for carrying on alone if the bot goes away
+    long round_trips;
+    double total_micros;
+    double max_micros;
+    int rejects;                                // answers in a row that weren't an untried cell (see accepted)
+    bool awaiting;                              // requestAttack has asked the bot, and pollAttack hasn't had the answer
+    chrono::steady_clock::time_point asked;     // when it asked
+    chrono::steady_clock::time_point checked;   // when pollAttack last made sure the bot is still running
+};
+
+BotPlayer::BotPlayer(string path, string nm, const Game& g)
+ : Player(nm, g), channel(nullptr), bot(-1), moves(g), round_trips(0), total_micros(0), max_micros(0), rejects(0), awaiting(false) {
+    /*
+     makes the shared memory, starts the bot with its name as the only argument, and describes the game to it.
+     The name is unlinked as soon as the bot has answered, so nothing is left behind however the game ends
+     */
+    static atomic<int> n_channels(0);
+    string name = "/battleship_bot_" + to_string(getpid()) + "_" + to_string(n_channels++);
+    channel = bot_create_channel(name.c_str());
+    if (channel == nullptr) {return;}
+
+    bot = fork();
+    if (bot == 0) {
+        execl(path.c_str(), path.c_str(), name.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    BotMessage hello = bot_message(BOT_HELLO);
+    hello.value[0] = g.rows();
+    hello.value[1] = g.cols();
+    hello.value[2] = g.nShips();
+    bool ok = bot > 0 && send(hello);
+    for (int s = 0; ok && s < g.nShips(); ++s) {
+        const ShipShape& shape = g.shipShape(s);
+        const vector<Point>& cells = shape.cells(0);
+        for (int first = 0, N = shape.size(); ok && first < N; first += BOT_CELLS_PER_SHIP_MESSAGE) {
+            BotMessage ship = bot_message(BOT_SHIP);
+            ship.value[0] = s;
+            ship.value[1] = g.shipSymbol(s);
+            ship.value[2] = N;
+            ship.value[3] = shape.orientations();
+            ship.value[4] = first;
+            for (int i = first; i < N && i < first + BOT_CELLS_PER_SHIP_MESSAGE; ++i) {
+                ship.value[5 + i - first] = (cells[i].r << 8) | cells[i].c;
+            }
+            ok = send(ship);
+        }
+    }
+    BotMessage ready;
+    ok = ok && receive(ready, BOT_READY);
+    shm_unlink(name.c_str());
+    if (!ok) {disconnect();}
+}
+
+BotPlayer::~BotPlayer() {
+    if (channel != nullptr) { bot_try_send(channel->to_bot, bot_message(BOT_QUIT));}
+    disconnect();
+}
+
+bool BotPlayer::alive() {
+    return bot > 0 && waitpid(bot, nullptr, WNOHANG) == 0;
+}
+
+void BotPlayer::disconnect() {
+    // gives the bot a moment to leave on its own before making sure it has
+    if (bot > 0) {
+        for (int i = 0; i < 100 && waitpid(bot, nullptr, WNOHANG) == 0; ++i) { this_thread::sleep_for(chrono::milliseconds(1));}
+        if (waitpid(bot, nullptr, WNOHANG) == 0) {
+            kill(bot, SIGKILL);
+            waitpid(bot, nullptr, 0);
+        }
+        bot = -1;
+    }
+    if (channel != nullptr) { bot_close_channel(channel);}
+    channel = nullptr;
+}
+
+bool BotPlayer::send(const BotMessage& m) {
+    if (channel == nullptr) {return false;}
+    if (bot_send(channel->to_bot, m, [this] { return alive();})) {return true;}
+    disconnect();
+    return false;
+}
+
+bool BotPlayer::receive(BotMessage& m, int expectedType, int otherType) {
+    // anything but an expected reply means the bot has lost track of the game, so we stop listening to it
+    if (channel == nullptr) {return false;}
+    if (bot_receive(channel->to_game, m, [this] { return alive();}) && (m.type == expectedType || m.type == otherType)) {return true;}
+    disconnect();
+    return false;
+}
+
+bool BotPlayer::placeShips(Board& b) {
+    /*
+     a bot that answers PLACEMENT_FAILED couldn't fit its ships, which is a legal answer like any other player's false.
+     If the bot has gone away (or goes away now), a mediocre player places the ships instead,
+     so the game carries on without it, as its attacks do
+     */
+    if (send(bot_message(BOT_PLACE_SHIPS))) {
+        int placed = 0;
+        BotMessage placement;
+        while (placed < game().nShips() && receive(placement, BOT_PLACEMENT, BOT_PLACEMENT_FAILED)) {
+            if (placement.type == BOT_PLACEMENT_FAILED ||
+                !b.placeShip(Point(placement.value[1], placement.value[2]), placement.value[0], placement.value[3])) {
+                b.clear();
+                return false;
+            }
+            ++placed;
+        }
+        if (placed == game().nShips()) {return true;}
+        b.clear();
+    }
+    Player* standIn = createPlayer("mediocre", name(), game());
+    bool ok = standIn->placeShips(b);
+    delete standIn;
+    return ok;
+}
+
+const int MAX_REJECTS = 3;
+
+bool BotPlayer::accepted(Point p) {
+    /*
+     whether the bot's attack is one to pass on to the game: a cell on the board that hasn't been tried.
+     Anything else would only come back as an invalid shot and be asked for again, and a bot that keeps
+     answering the same cell would hold the game up forever. So the bot is told it was invalid and asked again here,
+     and after MAX_REJECTS such answers in a row it is disconnected and we carry on without it
+     */
+    if (moves.is_untried(p)) { rejects = 0; return true;}
+    if (++rejects >= MAX_REJECTS) {
+        disconnect();
+        return false;
+    }
+    recordAttackResult(p, false, false, false, -1);
+    return false;
+}
+
+Point BotPlayer::recommendAttack() {
+    auto start = chrono::steady_clock::now();
+    BotMessage attack;
+    while (send(bot_message(BOT_RECOMMEND)) && receive(attack, BOT_ATTACK)) {
+        Point p(attack.value[0], attack.value[1]);
+        if (accepted(p)) {
+            time_round_trip(start);
+            return p;
+        }
+    }
+    return moves.random_untried();
+}
+
+void BotPlayer::requestAttack() {
+    asked = checked = chrono::steady_clock::now();
+    awaiting = send(bot_message(BOT_RECOMMEND));
+}
+
+bool BotPlayer::pollAttack(Point& p) {
+    /*
+     the bot's answer to requestAttack, if it has come, without waiting for it.
+     Until it comes, the bot is looked in on about once a millisecond, as bot_wait does,
+     and if it has gone (or answers with anything else) we carry on without it.
+     An attack we can't use is turned back (see accepted) and the answer to the next request awaited instead
+     */
+    BotMessage attack;
+    if (awaiting && !bot_try_receive(channel->to_game, attack)) {
+        auto now = chrono::steady_clock::now();
+        if (now - checked < chrono::milliseconds(1) || alive()) {
+            if (now - checked >= chrono::milliseconds(1)) { checked = now;}
+            return false;
+        }
+        disconnect();
+        awaiting = false;
+    }
+    if (!awaiting) {
+        p = moves.random_untried();
+        return true;
+    }
+    awaiting = false;
+    if (attack.type != BOT_ATTACK) {
+        disconnect();
+        p = moves.random_untried();
+        return true;
+    }
+    Point answer(attack.value[0], attack.value[1]);
+    if (!accepted(answer)) {
+        awaiting = connected() && send(bot_message(BOT_RECOMMEND));
+        if (awaiting) {return false;}
+        p = moves.random_untried();
+        return true;
+    }
+    time_round_trip(asked);
+    p = answer;
+    return true;
+}
+
+void BotPlayer::time_round_trip(chrono::steady_clock::time_point start) {
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    ++round_trips;
+    total_micros += micros;
+    if (micros > max_micros) {max_micros = micros;}
+}
+
+void BotPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId) {
+    if (validShot) { moves.record(p, shotHit);}
+    BotMessage result = bot_message(BOT_ATTACK_RESULT);
+    result.value[0] = p.r;
+    result.value[1] = p.c;
+    result.value[2] = validShot;
+    result.value[3] = shotHit;
+    result.value[4] = shipDestroyed;
+    result.value[5] = shipId;
+    send(result);
+}
+
+void BotPlayer::recordAttackByOpponent(Point p) {
+    BotMessage attack = bot_message(BOT_OPPONENT_ATTACK);
+    attack.value[0] = p.r;
+    attack.value[1] = p.c;
+    send(attack);
+}
+
+double BotPlayer::ping(long n) {
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < n; ++i) {
+        BotMessage pong;
+        if (!send(bot_message(BOT_PING)) || !receive(pong, BOT_PONG)) {return -1;}
+    }
+    return n > 0 ? chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / n : 0;
+}
+
+BotTiming BotPlayer::timing() const {
+    BotTiming t = { round_trips, round_trips > 0 ? total_micros / round_trips : 0, max_micros };
+    return t;
+}
+
+
+//*********************************************************************
+//  createBotPlayer
+//*********************************************************************
+
+Player* createBotPlayer(string path, string nm, const Game& g) {
+    BotPlayer* p = new BotPlayer(path, nm, g);
+    if (!p->connected()) {
+        delete p;
+        return nullptr;
+    }
+    return p;
+}
+
+BotTiming botTiming(const Player* p) {
+    const BotPlayer* bp = dynamic_cast<const BotPlayer*>(p);
+    BotTiming none = { 0, 0, 0 };
+    return bp != nullptr ? bp->timing() : none;
+}
+
+double pingBot(Player* p, long n) {
+    BotPlayer* bp = dynamic_cast<BotPlayer*>(p);
+    return bp != nullptr ? bp->ping(n) : -1;
+}
@@ -0,0 +1,45 @@
+//
+//  BotPlayer.h
+//  Battleship
+//
+
+#ifndef BOTPLAYER_INCLUDED
+#define BOTPLAYER_INCLUDED
+
+#include <string>
+
+/*
+ A BotPlayer is a Player whose decisions are made by a bot running as a separate program,
+ so bots can be built (in any language) and tested without compiling them into this one.
+ createPlayer("bot:<path to the bot>", ...) starts the bot and connects to it;
+ every placeShips, recommendAttack and record call is then passed on over shared memory (see BotProtocol.h).
+ In a game played a step at a time (see Game::step), requestAttack sends the request and pollAttack
+ looks for the answer without waiting, so the game's thread can get on with other games while the bot thinks.
+
+ If the bot can't be started, createPlayer returns nullptr, the same as for an unknown type.
+ If the bot dies or hangs part way through a game, the BotPlayer carries on by itself,
+ shooting random untried cells, so the game still ends.
+
+ bots/ReferenceBot.cpp is a small hunt and target bot to start from:
+     g++ -std=c++17 -O2 -o reference_bot bots/ReferenceBot.cpp
+ */
+
+class Player;
+class Game;
+
+struct BotTiming
+{
+    long round_trips;       // attacks answered by the bot (recommendAttack, or requestAttack and pollAttack)
+    double mean_micros;     // their average round trip, bot's thinking included
+    double max_micros;
+};
+
+Player* createBotPlayer(std::string path, std::string nm, const Game& g);
+
+// the timings of a player made by createBotPlayer (all zero for any other player)
+BotTiming botTiming(const Player* p);
+
+// times n PING/PONG round trips, the protocol's cost with no thinking at all; returns the mean in microseconds
+double pingBot(Player* p, long n);
+
+#endif // BOTPLAYER_INCLUDED
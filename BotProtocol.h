@@ -0,0 +1,170 @@
+//
+//  BotProtocol.h
+//  Battleship
+//
+
+#ifndef BOTPROTOCOL_INCLUDED
+#define BOTPROTOCOL_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ The protocol between BotPlayer (see BotPlayer.h) and a bot running as a separate process.
+ This header is all a bot needs: it doesn't depend on anything else in the project.
+
+ The two processes share one small block of memory (POSIX shared memory, named by the game)
+ holding two rings of fixed size messages, one each way. Each ring has a single writer and a single reader,
+ so it needs no locks: the writer fills a slot and then moves `write` along, the reader copies a slot out
+ and then moves `read` along, and each index is only ever stored by one side.
+ A waiting side spins for a few microseconds (when there is more than one core), then yields,
+ then sleeps a little between looks, so a quick reply costs a couple of microseconds
+ and a slow bot doesn't cost the game a core.
+
+ A game goes like this (G: game to bot, B: bot to game):
+     G HELLO rows cols nShips
+     G SHIP  shipId symbol nCells nOrientations firstCell cells...   (as many as it takes per ship)
+     B READY
+     G PLACE_SHIPS                   B PLACEMENT shipId r c orientation, one per ship (or PLACEMENT_FAILED)
+     G RECOMMEND                     B ATTACK r c
+     G ATTACK_RESULT r c validShot shotHit shipDestroyed shipId
+     G OPPONENT_ATTACK r c
+     G PING                          B PONG
+     G QUIT
+ Ship cells are those of orientation 0 (see ShipShape.h), shifted so the top row and left column are 0,
+ each as (r << 8) | c. Straight ships have orientation 0 along a row and orientation 1 down a column.
+ */
+
+const uint32_t BOT_MAGIC = 0x42534250;      // "BSBP"
+const uint32_t BOT_VERSION = 1;
+const uint32_t BOT_RING_SLOTS = 256;        // a power of 2, so the indices can just keep counting up and wrap
+const int BOT_CELLS_PER_SHIP_MESSAGE = 10;
+
+enum BotMessageType {
+    BOT_HELLO, BOT_SHIP, BOT_READY, BOT_PLACE_SHIPS, BOT_PLACEMENT, BOT_PLACEMENT_FAILED,
+    BOT_RECOMMEND, BOT_ATTACK, BOT_ATTACK_RESULT, BOT_OPPONENT_ATTACK, BOT_PING, BOT_PONG, BOT_QUIT
+};
+
+struct BotMessage
+{
+    int32_t type;
+    int32_t value[15];  // 64 bytes in all, one cache line
+};
+
+struct BotRing
+{
+    alignas(64) std::atomic<uint32_t> read;     // only the reader stores this
+    alignas(64) std::atomic<uint32_t> write;    // only the writer stores this
+    alignas(64) BotMessage slots[BOT_RING_SLOTS];
+};
+
+struct BotChannel
+{
+    uint32_t magic;
+    uint32_t version;
+    BotRing to_bot;
+    BotRing to_game;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the rings need lock free atomics to work across processes");
+
+inline bool bot_try_send(BotRing& ring, const BotMessage& m) {
+    uint32_t w = ring.write.load(std::memory_order_relaxed);
+    if (w - ring.read.load(std::memory_order_acquire) == BOT_RING_SLOTS) {return false;}   // full
+    ring.slots[w % BOT_RING_SLOTS] = m;
+    ring.write.store(w + 1, std::memory_order_release);
+    return true;
+}
+
+inline bool bot_try_receive(BotRing& ring, BotMessage& m) {
+    uint32_t r = ring.read.load(std::memory_order_relaxed);
+    if (r == ring.write.load(std::memory_order_acquire)) {return false;}                    // empty
+    m = ring.slots[r % BOT_RING_SLOTS];
+    ring.read.store(r + 1, std::memory_order_release);
+    return true;
+}
+
+// waits until ready() is true, checking alive() about once a millisecond and giving up once it is false
+template<typename Ready, typename Alive> bool bot_wait(Ready ready, Alive alive) {
+    // spinning only helps if the other side is running on another core at the same time
+    static const int SPINS = std::thread::hardware_concurrency() > 1 ? 2000 : 0;
+    for (int spin = 0; spin < SPINS; ++spin) {
+        if (ready()) {return true;}
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto last_check = start;
+    while (!ready()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check > std::chrono::milliseconds(1)) {
+            if (!alive()) {return false;}
+            last_check = now;
+        }
+        if (now - start < std::chrono::milliseconds(1)) { std::this_thread::yield();}
+        else                                           { std::this_thread::sleep_for(std::chrono::microseconds(50));}
+    }
+    return true;
+}
+
+template<typename Alive> bool bot_send(BotRing& ring, const BotMessage& m, Alive alive) {
+    return bot_wait([&ring, &m] { return bot_try_send(ring, m);}, alive);
+}
+
+template<typename Alive> bool bot_receive(BotRing& ring, BotMessage& m, Alive alive) {
+    return bot_wait([&ring, &m] { return bot_try_receive(ring, m);}, alive);
+}
+
+inline BotMessage bot_message(int32_t type) {
+    BotMessage m;
+    std::memset(&m, 0, sizeof(m));
+    m.type = type;
+    return m;
+}
+
+// the game's side: creates the shared memory under the given name, nullptr if it can't
+inline BotChannel* bot_create_channel(const char* name) {
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {return nullptr;}
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, sizeof(BotChannel)) == 0) {
+        mapped = mmap(nullptr, sizeof(BotChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) { shm_unlink(name); return nullptr;}
+    BotChannel* channel = static_cast<BotChannel*>(mapped);
+    new (&channel->to_bot.read) std::atomic<uint32_t>(0);
+    new (&channel->to_bot.write) std::atomic<uint32_t>(0);
+    new (&channel->to_game.read) std::atomic<uint32_t>(0);
+    new (&channel->to_game.write) std::atomic<uint32_t>(0);
+    channel->version = BOT_VERSION;
+    channel->magic = BOT_MAGIC;
+    return channel;
+}
+
+// the bot's side: maps the game's shared memory, nullptr if it isn't there or isn't a channel
+inline BotChannel* bot_open_channel(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0) {return nullptr;}
+    void* mapped = mmap(nullptr, sizeof(BotChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {return nullptr;}
+    BotChannel* channel = static_cast<BotChannel*>(mapped);
+    if (channel->magic != BOT_MAGIC || channel->version != BOT_VERSION) {
+        munmap(mapped, sizeof(BotChannel));
+        return nullptr;
+    }
+    return channel;
+}
+
+inline void bot_close_channel(BotChannel* channel) { munmap(channel, sizeof(BotChannel));}
+
+#endif // BOTPROTOCOL_INCLUDED
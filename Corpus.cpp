@@ -0,0 +1,158 @@
+//
+//  Corpus.cpp
+//  Battleship
+//
+
+#include "Corpus.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "ShipShape.h"
+#include "OpeningBook.h"
+#include <fstream>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+const size_t CORPUS_HEADER_SIZE = 20;
+const unsigned char CORPUS_VERSION = 1;
+
+//*********************************************************************
+//  LayoutCorpus
+//*********************************************************************
+
+LayoutCorpus::LayoutCorpus() : data(nullptr), length(0), count(0), n_ships(0) {}
+
+LayoutCorpus::~LayoutCorpus() { close();}
+
+bool LayoutCorpus::generate(const string& path, const Game& g, long count) {
+    /*
+     every layout is drawn uniformly from all legal layouts:
+     each ship gets a random one of its placements on the board, and if any ship
+     overlaps another, the whole layout is thrown out and drawn again
+     (unlike MediocrePlayer's placement, this doesn't favor any part of the board)
+     */
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {return false;}
+
+    int n_ships = g.nShips();
+    unsigned char header[CORPUS_HEADER_SIZE] = { 'B', 'S', 'L', 'C',
+        static_cast<unsigned char>(g.rows()), static_cast<unsigned char>(g.cols()), static_cast<unsigned char>(n_ships), CORPUS_VERSION,
+        static_cast<unsigned char>(count), static_cast<unsigned char>(count >> 8),
+        static_cast<unsigned char>(count >> 16), static_cast<unsigned char>(count >> 24) };
+    uint64_t fingerprint = fleet_fingerprint(g);
+    for (int i = 0; i < 8; ++i) { header[12 + i] = static_cast<unsigned char>(fingerprint >> (8*i));}
+    out.write(reinterpret_cast<const char*>(header), CORPUS_HEADER_SIZE);
+    for (int s = 0; s < n_ships; ++s) { out.put(static_cast<char>(g.shipLength(s)));}
+
+    vector<unsigned char> layout(3*n_ships);
+    for (long k = 0; k < count; ++k) {
+        bool placed = false;
+        while (!placed) {
+            CellSet occupied;
+            placed = true;
+            for (int s = 0; s < n_ships && placed; ++s) {
+                const ShipShape& shape = g.shipShape(s);
+                const ShipPlacement& L = shape.placement(randInt(shape.placements()));
+                if ((occupied & L.mask).any()) {placed = false; break;}
+                occupied |= L.mask;
+                layout[3*s]     = static_cast<unsigned char>(L.topOrLeft.r);
+                layout[3*s + 1] = static_cast<unsigned char>(L.topOrLeft.c);
+                layout[3*s + 2] = static_cast<unsigned char>(L.orientation);
+            }
+        }
+        out.write(reinterpret_cast<const char*>(layout.data()), layout.size());
+    }
+    return static_cast<bool>(out);
+}
+
+bool LayoutCorpus::open(const string& path, const Game& g) {
+    // maps the file and checks that it was built for this game's board and fleet, ship shapes and all
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {return false;}
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < CORPUS_HEADER_SIZE) { ::close(fd); return false;}
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping stays valid after the descriptor is closed
+    if (mapped == MAP_FAILED) {return false;}
+    data = static_cast<const unsigned char*>(mapped);
+    length = info.st_size;
+
+    n_ships = data[6];
+    count = static_cast<long>(data[8]) | static_cast<long>(data[9]) << 8 |
+            static_cast<long>(data[10]) << 16 | static_cast<long>(data[11]) << 24;
+    uint64_t fingerprint = 0;
+    for (int i = 0; i < 8; ++i) { fingerprint |= static_cast<uint64_t>(data[12 + i]) << (8*i);}
+    bool matches = data[0] == 'B' && data[1] == 'S' && data[2] == 'L' && data[3] == 'C' && data[7] == CORPUS_VERSION &&
+                   data[4] == g.rows() && data[5] == g.cols() && n_ships == g.nShips() && fingerprint == fleet_fingerprint(g) &&
+                   length >= CORPUS_HEADER_SIZE + n_ships + 3*static_cast<size_t>(n_ships)*count;
+    for (int s = 0; matches && s < n_ships; ++s) {
+        if (data[CORPUS_HEADER_SIZE + s] != g.shipLength(s)) {matches = false;}
+    }
+    if (!matches) {close(); return false;}
+    return true;
+}
+
+void LayoutCorpus::close() {
+    if (data != nullptr) { munmap(const_cast<unsigned char*>(data), length);}
+    data = nullptr;
+    length = 0;
+    count = 0;
+    n_ships = 0;
+}
+
+const unsigned char* LayoutCorpus::record(long layout, int shipId) const {
+    return data + CORPUS_HEADER_SIZE + n_ships + 3*(static_cast<size_t>(layout)*n_ships + shipId);
+}
+
+Point LayoutCorpus::top_or_left(long layout, int shipId) const {
+    const unsigned char* r = record(layout, shipId);
+    return Point(r[0], r[1]);
+}
+
+int LayoutCorpus::orientation(long layout, int shipId) const { return record(layout, shipId)[2];}
+
+
+//*********************************************************************
+//  CorpusPlayer
+//*********************************************************************
+
+class CorpusPlayer : public Player
+{
+  public:
+    CorpusPlayer(const LayoutCorpus& corpus, long layout, string nm, const Game& g);
+    bool placeShips(Board& b) override;
+    Point recommendAttack() override;
+    void recordAttackResult(Point /* p */, bool /* validShot */, bool /* shotHit */, bool /* shipDestroyed */,
+                            int /* shipId */) override {return;};
+    void recordAttackByOpponent(Point /* p */) override {return;};
+  private:
+    const LayoutCorpus& m_corpus;
+    long m_layout;
+    int next_cell;
+};
+
+CorpusPlayer::CorpusPlayer(const LayoutCorpus& corpus, long layout, string nm, const Game& g)
+ : Player(nm, g), m_corpus(corpus), m_layout(layout), next_cell(0) {}
+
+bool CorpusPlayer::placeShips(Board& b) {
+    if (m_layout < 0 || m_layout >= m_corpus.size()) {return false;}
+    for (int s = 0; s < game().nShips(); ++s) {
+        if (!b.placeShip(m_corpus.top_or_left(m_layout, s), s, m_corpus.orientation(m_layout, s))) {return false;}
+    }
+    return true;
+}
+
+Point CorpusPlayer::recommendAttack() {
+    int cell = next_cell++ % (game().rows()*game().cols());
+    return Point(cell / game().cols(), cell % game().cols());
+}
+
+Player* createCorpusPlayer(const LayoutCorpus& corpus, long layout, string nm, const Game& g) {
+    return new CorpusPlayer(corpus, layout, nm, g);
+}
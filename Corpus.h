@@ -0,0 +1,60 @@
+//
+//  Corpus.h
+//  Battleship
+//
+
+#ifndef CORPUS_INCLUDED
+#define CORPUS_INCLUDED
+
+#include "globals.h"
+#include <string>
+#include <cstddef>
+
+/*
+ A layout corpus is a file of pre-built fleet placements, so different AIs can be tested against the exact same boards.
+ Most of the spread in "turns to win" comes from where the ships happen to be,
+ so comparing two AIs on identical layouts needs far fewer games than comparing them on fresh random ones.
+
+ File format (all integers little endian):
+     "BSLC"                                  4 bytes
+     rows, cols, number of ships, version    1 byte each
+     number of layouts                       4 bytes
+     fleet fingerprint                       8 bytes (see fleet_fingerprint in OpeningBook.h)
+     ship lengths (cells, for any shape)     1 byte per ship
+     layouts                                 3 bytes (row, col, orientation) per ship, per layout
+
+ generate() writes a corpus of uniformly random layouts,
+ open() memory maps one so layouts can be read without loading the whole file.
+ */
+
+class Game;
+class Player;
+
+class LayoutCorpus
+{
+  public:
+    LayoutCorpus();
+    ~LayoutCorpus();
+    static bool generate(const std::string& path, const Game& g, long count);
+    bool open(const std::string& path, const Game& g);
+    void close();
+    long size() const { return count;}
+    Point top_or_left(long layout, int shipId) const;
+    int orientation(long layout, int shipId) const;
+      // We prevent a LayoutCorpus object from being copied or assigned
+    LayoutCorpus(const LayoutCorpus&) = delete;
+    LayoutCorpus& operator=(const LayoutCorpus&) = delete;
+  private:
+    const unsigned char* record(long layout, int shipId) const;
+    const unsigned char* data;
+    size_t length;
+    long count;
+    int n_ships;
+};
+
+// A player that places its ships exactly as layout number `layout` of the corpus,
+// and attacks by sweeping the board in order (though as the second player of a
+// one sided game, see Game::setOneSided, it never gets to)
+Player* createCorpusPlayer(const LayoutCorpus& corpus, long layout, std::string nm, const Game& g);
+
+#endif // CORPUS_INCLUDED
@@ -0,0 +1,128 @@
+//
+//  Evaluation.cpp
+//  Battleship
+//
+
+#include "Evaluation.h"
+#include "Game.h"
+#include "Possibilities.h"
+#include "ShipShape.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+using namespace std;
+
+PositionEvaluator::PositionEvaluator(int samplesPerPosition) : samples(samplesPerPosition) {}
+
+PositionEvaluator::~PositionEvaluator() {}
+
+const Game* PositionEvaluator::game_for(const Position& p) {
+    /*
+     finds (or builds) the Game for the position's board and fleet.
+     Everything Game::addShip would complain about is checked here first, so a bad fleet is just a nullptr
+     rather than a message on cout, and a bad board size doesn't exit the program the way Game's constructor does
+     */
+    string key = to_string(p.rows) + 'x' + to_string(p.cols);
+    for (size_t s = 0, N = p.ships.size(); s < N; ++s) {
+        key += ';';
+        for (size_t i = 0, M = p.ships[s].size(); i < M; ++i) {
+            key += to_string(p.ships[s][i].r) + ',' + to_string(p.ships[s][i].c) + ' ';
+        }
+    }
+    auto found = games.find(key);
+    if (found != games.end()) {return found->second.get();}
+
+    unique_ptr<Game>& g = games[key];
+    if (p.rows < 1 || p.rows > MAXROWS || p.cols < 1 || p.cols > MAXCOLS || p.ships.empty()) {return nullptr;}
+
+    // the ships get symbols of their own, skipping the characters the boards use
+    vector<char> symbols;
+    for (char c = '!'; c <= '~'; ++c) {
+        if (c != 'X' && c != '.' && c != 'o' && c != '-') { symbols.push_back(c);}
+    }
+    if (p.ships.size() > symbols.size()) {return nullptr;}
+    size_t total = 0;
+    for (size_t s = 0, N = p.ships.size(); s < N; ++s) {
+        if (!ShipShape::is_polyomino(p.ships[s]) || ShipShape(p.ships[s], p.rows, p.cols).placements() == 0) {return nullptr;}
+        total += p.ships[s].size();
+    }
+    if (total > static_cast<size_t>(p.rows * p.cols)) {return nullptr;}
+
+    g.reset(new Game(p.rows, p.cols));
+    for (size_t s = 0, N = p.ships.size(); s < N; ++s) { g->addShip(p.ships[s], symbols[s], string(1, symbols[s]));}
+    return g.get();
+}
+
+bool load_position(const Game& g, const Position& p, Possibilities_Board& board) {
+    // the position goes onto the board exactly as GoodPlayer::recordAttackResult would put it
+    int n_cells = g.rows() * g.cols();
+    if (static_cast<int>(p.shots.size()) != n_cells || p.sunk_at.size() != static_cast<size_t>(g.nShips())) {return false;}
+    for (int i = 0; i < n_cells; ++i) {
+        char c = p.shots[i];
+        if (c == 'o' || c == 'X') { board.update(Point(i / g.cols(), i % g.cols()), c);}
+        else if (c != '.') {return false;}
+    }
+    for (int s = 0, N = g.nShips(); s < N; ++s) {
+        int cell = p.sunk_at[s];
+        if (cell < 0) {continue;}
+        if (cell >= n_cells || p.shots[cell] != 'X') {return false;}
+        board.ship_destroyed(s);
+        board.update(Point(cell / g.cols(), cell % g.cols()), g.shipSymbol(s));
+    }
+    return true;
+}
+
+bool PositionEvaluator::evaluate_one(const Game& g, const Position& p, vector<int>& counts, vector<double>& result,
+                                     mt19937& generator) const {
+    int n_cells = g.rows() * g.cols();
+    result.clear();
+    Possibilities_Board board(g);
+    if (!load_position(g, p, board)) {return false;}
+    board.determine_locations();
+
+    counts.assign(n_cells, 0);
+    long accepted = 0;
+    for (int i = 0; i < samples; ++i) {
+        if (board.place_ships(generator) && board.is_valid_board()) {
+            board.read_to(counts);
+            ++accepted;
+        }
+        board.unplace_all_ships();
+    }
+
+    /*
+     read_to only counts cells the sample placed a ship on, so a ship that determine_locations found
+     only one place for (and fixed on the board) isn't in the counts: its unshot cells are certain hits
+     */
+    result.assign(n_cells, 0.0);
+    if (accepted == 0) {return true;}
+    for (int i = 0; i < n_cells; ++i) {
+        if (p.shots[i] != '.') {continue;}
+        result[i] = static_cast<double>(counts[i]) / accepted;
+        for (int s = 0, N = g.nShips(); s < N; ++s) {
+            if (board.ship_cells(s)[i]) {result[i] = 1;}
+        }
+    }
+    return true;
+}
+
+int PositionEvaluator::evaluate(const vector<Position>& positions, vector<vector<double>>& probabilities) {
+    // the games are looked up first, on this thread, so the tasks only ever read them
+    vector<const Game*> position_games(positions.size());
+    for (size_t k = 0, N = positions.size(); k < N; ++k) { position_games[k] = game_for(positions[k]);}
+    probabilities.resize(positions.size());
+    if (counts.size() < positions.size()) { counts.resize(positions.size());}
+
+    atomic<int> evaluated(0);
+    const unsigned int task_seed = randomGenerator()();
+    TaskGroup group;
+    for (size_t k = 0, N = positions.size(); k < N; ++k) {
+        if (position_games[k] == nullptr) { probabilities[k].clear(); continue;}
+        group.run([this, k, task_seed, &positions, &position_games, &probabilities, &evaluated] {
+            mt19937 generator = taskGenerator(task_seed, static_cast<unsigned int>(k));
+            if (evaluate_one(*position_games[k], positions[k], counts[k], probabilities[k], generator)) {++evaluated;}
+        });
+    }
+    group.wait();
+    return evaluated;
+}
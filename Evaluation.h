@@ -0,0 +1,71 @@
+//
+//  Evaluation.h
+//  Battleship
+//
+
+#ifndef EVALUATION_INCLUDED
+#define EVALUATION_INCLUDED
+
+#include "globals.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ Position evaluation for code outside the game: give it a batch of positions
+ and it gives back, for every cell of every position, the chance that a shot there hits.
+ It is the same sampling GoodPlayer does before each shot (Possibilities_Board), without playing a game.
+
+ A position is what the attacker knows:
+     rows, cols   the board
+     ships        the fleet, each ship as its cells (ShipShape::straight(n) for a straight ship of length n)
+     shots        rows*cols characters, row by row: '.' not shot, 'o' a miss, 'X' a hit
+     sunk_at      for each ship, the cell (r*cols + c) of the hit that sank it, or -1 if it is still afloat
+ The result for a position is rows*cols probabilities, 0 for cells that have been shot.
+ A position that doesn't make sense (bad board size or fleet, wrong grid size,
+ a ship sunk on a cell that isn't a hit) gets an empty result instead.
+
+ Positions are evaluated in parallel on the shared ThreadPool, one task per position,
+ each sampling from its own generator so the answers don't depend on which thread ran it.
+ The evaluator keeps a Game for every board and fleet it has seen, and its count buffers,
+ so scoring batch after batch of positions from the same kind of game doesn't rebuild anything.
+ This only needs Evaluation, Possibilities, ShipShape, Game, Board and ThreadPool,
+ not the players or main, so it can be built into a library on its own.
+ */
+
+class Game;
+class Possibilities_Board;
+
+struct Position
+{
+    int rows;
+    int cols;
+    std::vector<std::vector<Point>> ships;
+    std::string shots;
+    std::vector<int> sunk_at;
+};
+
+class PositionEvaluator
+{
+  public:
+    explicit PositionEvaluator(int samplesPerPosition = 2000);
+    ~PositionEvaluator();
+    // fills probabilities[k] for positions[k], and returns how many positions could be evaluated
+    int evaluate(const std::vector<Position>& positions, std::vector<std::vector<double>>& probabilities);
+      // We prevent a PositionEvaluator object from being copied or assigned
+    PositionEvaluator(const PositionEvaluator&) = delete;
+    PositionEvaluator& operator=(const PositionEvaluator&) = delete;
+  private:
+    const Game* game_for(const Position& p);
+    bool evaluate_one(const Game& g, const Position& p, std::vector<int>& counts, std::vector<double>& result,
+                      std::mt19937& generator) const;
+    int samples;
+    std::map<std::string, std::unique_ptr<Game>> games;     // by board size and fleet, nullptr if it isn't a valid game
+    std::vector<std::vector<int>> counts;                   // one buffer per position of the batch
+};
+
+// puts a position's shots onto a fresh possibilities board for g, as GoodPlayer would have; false if it doesn't make sense
+bool load_position(const Game& g, const Position& p, Possibilities_Board& board);
+
+#endif // EVALUATION_INCLUDED
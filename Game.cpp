@@ -1,11 +1,15 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
+#include "ShipShape.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <chrono>
+#include <limits>
+#include <thread>
 
 using namespace std;
 
@@ -18,26 +22,87 @@ class GameImpl
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
-    bool addShip(int length, char symbol, string name);
+    bool addShip(const ShipShape& shape, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
+    const ShipShape& shipShape(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
+    const Fleet& fleet() const { return m_fleet;}
     void display() const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    void start(Player* p1, Player* p2, Board* b1, Board* b2, bool shouldPause);
+    GameStep step();
+    Player* winner() const { return the_winner;}
+    int turnsTaken() const;
+    void setTimeControl(const TimeControl& tc);
+    TimeControl timeControl() const;
+    double timeRemaining(const Player* p) const;
+    double moveTimeRemaining(const Player* p) const;
+    MoveTimes moveTimes(const Player* p) const;
+    void setSalvo(int shotsPerTurn);
+    int salvo() const;
+    void setOneSided(bool oneSided) { one_sided = oneSided;}
+    bool oneSided() const { return one_sided;}
   private:
     struct Ship {
-        Ship(int _length, char _symbol, string _name);
-        int length;
+        Ship(const ShipShape& _shape, char _symbol, string _name);
+        int length;             // number of cells, whatever the shape
         char symbol;
         string name;
+        ShipShape shape;
     };
     int nRows;
     int nCols;
+    int lastTurns; // valid attacks made by the winner of the most recent game
     vector<Ship*> Ships;
+    Fleet m_fleet;  // Ships again, flat (see Game.h)
+
+    /*
+     Each player has a clock, which runs whenever the game is waiting on that player:
+     through its recommendAttack calls and its recordAttackResult (which make up its move),
+     and through its recordAttackByOpponent, which is charged to its budget but isn't part of any move
+     */
+    struct Clock {
+        const Player* player;
+        double bank;        // budget left in milliseconds, infinity with no total limit
+        bool running;
+        chrono::steady_clock::time_point started;
+        MoveTimes times;
+    };
+    TimeControl control;
+    Clock clocks[2];
+    
+    int salvo_shots;        // shots a turn, 1 for the ordinary game or SALVO_ONE_PER_SHIP
+    int afloat[2];          // each player's ships not yet sunk
+    bool one_sided;         // only player 1 attacks (see Game.h)
+    
+    /*
+     The game being played, a step at a time (see step). Player 1 is side 0, attacking boards[1],
+     and player 2 is side 1, attacking boards[0]; the boards belong to the game until it's over
+     */
+    enum Phase { PLACING, ATTACKING, AWAITING, FINISHED };
+    Phase phase;
+    Player* players[2];
+    Board* boards[2];
+    int to_move;
+    unsigned int turns[2];
+    size_t salvo_size;      // the shots asked for in the salvo being waited on
+    Player* the_winner;
+    GameStep attack_landed(Point p);
+    GameStep salvo_landed(vector<Point>& targets);
+    GameStep end_turn();
+    GameStep conclude(Player* timed_out);
+    GameStep end_game(Player* winner);
+    int clock_of(const Player* p) const;
+    void reset_clocks(const Player* p1, const Player* p2);
+    void start_clock(int which);
+    double clock_elapsed(int which) const;
+    double stop_clock(int which);
+    bool out_of_time(int which, double move) const;
+    void record_move(int which, double move);
 };
 
-GameImpl::Ship::Ship(int _length, char _symbol, string _name) : length(_length), symbol(_symbol), name(_name) {};
+GameImpl::Ship::Ship(const ShipShape& _shape, char _symbol, string _name) : length(_shape.size()), symbol(_symbol), name(_name), shape(_shape) {};
 
 void waitForEnter()
 {
@@ -45,12 +110,22 @@ void waitForEnter()
     cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int _nRows, int _nCols) : nRows(_nRows), nCols(_nCols) {}
+GameImpl::GameImpl(int _nRows, int _nCols) : nRows(_nRows), nCols(_nCols), lastTurns(0), salvo_shots(1), one_sided(false),
+    phase(FINISHED), to_move(0), salvo_size(0), the_winner(nullptr) {
+    players[0] = players[1] = nullptr;
+    boards[0] = boards[1] = nullptr;
+    control.moveMillis = control.totalMillis = control.incrementMillis = 0;
+    reset_clocks(nullptr, nullptr);
+    m_fleet.nShips = m_fleet.totalLength = 0;
+    for (size_t i = 0; i < 256; ++i) { m_fleet.idOf[i] = -1;}
+}
 GameImpl::~GameImpl() {
     // destructor loops through Ships to delete the ship at each pointer
     for (size_t i = 0, N = Ships.size(); i < N; ++i) {
         delete Ships[i];
     }
+    delete boards[0];
+    delete boards[1];
 }
 
 int GameImpl::rows() const { return nRows;}
@@ -64,99 +139,279 @@ Point GameImpl::randomPoint() const {
     return Point(randInt(rows()), randInt(cols()));
 }
 
-bool GameImpl::addShip(int length, char symbol, string name) {
-    // creates the Ship on heap and adds a pointer to it to ships
-    Ship* p = new Ship(length, symbol, name);
+bool GameImpl::addShip(const ShipShape& shape, char symbol, string name) {
+    // creates the Ship on heap and adds a pointer to it to ships, then adds it to the flat fleet
+    Ship* p = new Ship(shape, symbol, name);
     Ships.push_back(p);
+    m_fleet.idOf[static_cast<unsigned char>(symbol)] = m_fleet.nShips++;
+    m_fleet.totalLength += p->length;
+    m_fleet.lengths.push_back(p->length);
+    m_fleet.symbols.push_back(symbol);
+    m_fleet.shapes.push_back(&p->shape);
     return true;
 }
 
 int GameImpl::nShips() const { return static_cast<int>(Ships.size());}
 
-int    GameImpl::shipLength(int shipId) const { return Ships[shipId]->length;}
-char   GameImpl::shipSymbol(int shipId) const { return Ships[shipId]->symbol;}
+int    GameImpl::shipLength(int shipId) const { return m_fleet.lengths[shipId];}
+char   GameImpl::shipSymbol(int shipId) const { return m_fleet.symbols[shipId];}
 string GameImpl::shipName  (int shipId) const { return Ships[shipId]->name;  }
+const ShipShape& GameImpl::shipShape(int shipId) const { return Ships[shipId]->shape;}
 
+int GameImpl::turnsTaken() const { return lastTurns;}
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause) {
-    //placing ships and ensuring completion
-    cout << "Players may place their ships" << endl;
-    bool ships_placed_one = p1->placeShips(b1);
-    bool ships_placed_two = p2->placeShips(b2);
-    if (!(ships_placed_one && ships_placed_two)) {return nullptr;}
-    
-    cout << "All ships have been placed, let the game begin!" << endl << endl;
+void GameImpl::setTimeControl(const TimeControl& tc) { control = tc;}
+TimeControl GameImpl::timeControl() const { return control;}
 
-    //variables to change while attacking
-    
-    bool shotHit = 0;
-    bool shipDestroyed = 0;
-    int  shipId = -1;
-    bool whoseTurn = 1;
-    unsigned int turn_counter = 0;
-    
-    // end criteria, one board has all ships destroyed
-    while (!(b1.allShipsDestroyed() || b2.allShipsDestroyed())) {
-        if (whoseTurn) {
-            cout << p1->name() << "'s turn to attack" << endl;
-            cout << p2->name() << "'s board before the attack: " << endl;
-            b2.display(p1->isHuman());                                                  // display p2 board
-            
-            Point recomended = p1->recommendAttack();                                   // p1 recomends an attack
-            bool failtest = b2.attack(recomended, shotHit, shipDestroyed, shipId);      // p1 attacks
-            while (!failtest) {
-                p1->recordAttackResult(recomended, 0, shotHit, shipDestroyed, shipId);  // p1 records his failed attack
-                recomended = p1->recommendAttack();                                     // re-recomending and attacking
-                failtest = b2.attack(recomended, shotHit, shipDestroyed, shipId);       // if previous attack was invalid
-            }
-            cout << p2->name() << "'s board after the attack: " << endl;
-            b2.display(p1->isHuman());                                                  // display p2 board
-            p1->recordAttackResult(recomended, 1, shotHit, shipDestroyed, shipId);      // p1 records his attack
-            p2->recordAttackByOpponent(recomended);                                     // p2 records the attack
+int GameImpl::clock_of(const Player* p) const {
+    if (p != nullptr && clocks[0].player == p) {return 0;}
+    if (p != nullptr && clocks[1].player == p) {return 1;}
+    return -1;
+}
+
+void GameImpl::reset_clocks(const Player* p1, const Player* p2) {
+    const Player* players[2] = {p1, p2};
+    for (int k = 0; k < 2; ++k) {
+        clocks[k].player = players[k];
+        clocks[k].bank = control.totalMillis > 0 ? control.totalMillis : numeric_limits<double>::infinity();
+        clocks[k].running = false;
+        clocks[k].times.moves = 0;
+        clocks[k].times.totalMillis = 0;
+        clocks[k].times.maxMillis = 0;
+        clocks[k].times.flagged = false;
+    }
+}
+
+void GameImpl::start_clock(int which) {
+    clocks[which].running = true;
+    clocks[which].started = chrono::steady_clock::now();
+}
+
+double GameImpl::clock_elapsed(int which) const {
+    if (!clocks[which].running) {return 0;}
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - clocks[which].started).count();
+}
+
+double GameImpl::stop_clock(int which) {
+    double elapsed = clock_elapsed(which);
+    clocks[which].running = false;
+    clocks[which].bank -= elapsed;
+    return elapsed;
+}
+
+bool GameImpl::out_of_time(int which, double move) const {
+    return (control.moveMillis > 0 && move > control.moveMillis) || clocks[which].bank - clock_elapsed(which) < 0;
+}
+
+void GameImpl::record_move(int which, double move) {
+    // the increment only comes with a move made in time
+    MoveTimes& t = clocks[which].times;
+    ++t.moves;
+    t.totalMillis += move;
+    if (move > t.maxMillis) {t.maxMillis = move;}
+    if (out_of_time(which, move)) {t.flagged = true; return;}
+    clocks[which].bank += control.incrementMillis;
+}
+
+double GameImpl::timeRemaining(const Player* p) const {
+    // a player that isn't in the current game gets the budget a game starts with
+    int which = clock_of(p);
+    if (which < 0) {return control.totalMillis > 0 ? control.totalMillis : numeric_limits<double>::infinity();}
+    return clocks[which].bank - clock_elapsed(which);
+}
+
+double GameImpl::moveTimeRemaining(const Player* p) const {
+    double left = timeRemaining(p);
+    if (control.moveMillis <= 0) {return left;}
+    int which = clock_of(p);
+    return min(left, control.moveMillis - (which < 0 ? 0 : clock_elapsed(which)));
+}
+
+void GameImpl::setSalvo(int shotsPerTurn) { salvo_shots = shotsPerTurn < 0 ? 1 : shotsPerTurn;}
+int GameImpl::salvo() const { return salvo_shots;}
+
+MoveTimes GameImpl::moveTimes(const Player* p) const {
+    int which = clock_of(p);
+    MoveTimes none = {0, 0, 0, false};
+    return which < 0 ? none : clocks[which].times;
+}
+
+
+void GameImpl::start(Player* p1, Player* p2, Board* b1, Board* b2, bool shouldPause) {
+    // sets up a game for step, taking the boards over from Game::start
+    delete boards[0];
+    delete boards[1];
+    players[0] = p1;
+    players[1] = p2;
+    boards[0] = b1;
+    boards[1] = b2;
+    lastTurns = 0;
+    reset_clocks(p1, p2);
+    phase = PLACING;
+    to_move = 0;                    // p1 goes first
+    turns[0] = turns[1] = 0;
+    salvo_size = 0;
+    the_winner = nullptr;
+    afloat[0] = afloat[1] = nShips();
+}
+
+GameStep GameImpl::step() {
+    /*
+     step plays the game a piece at a time, so it can be left part way through and picked up again:
+     each call goes on from the phase it was left in, as far as it can without waiting on anyone.
+     The first step places both fleets; after that each turn is an attack.
+     
+     A turn asks the attacker for its attack (requestAttack, or requestSalvo) and goes to AWAITING;
+     each step after that polls for it (pollAttack, pollSalvo) until it's in. So a player working its attack out
+     somewhere else (a bot in another process, say) holds up no one but itself, and one thread can step
+     many games by turns. The attacker's clock runs from the request until the attack is in, and if it runs out
+     while the attacker is still thinking, the attacker loses right then instead of whenever its answer comes.
+     Every other call to a player (placing ships, hearing results) is made in one go.
+     Players that don't do anything with the requests work the attack out on the first poll
+     */
+    switch (phase) {
+        case FINISHED:
+            return GAME_OVER;
             
-            whoseTurn = 0;                                                              // changing turns
-            ++turn_counter;
-            if (turn_counter > nRows * nCols) { return nullptr;}                        // break condition
-            cout << endl;
+        case PLACING: {
+            cout << "Players may place their ships" << endl;
+            bool ships_placed_one = players[0]->placeShips(*boards[0]);
+            bool ships_placed_two = players[1]->placeShips(*boards[1]);
+            if (!(ships_placed_one && ships_placed_two)) {return end_game(nullptr);}
+            cout << "All ships have been placed, let the game begin!" << endl << endl;
+            phase = ATTACKING;
+            return GAME_STEPPED;
         }
-        else {
-            cout << p2->name() << "'s turn to attack" << endl;
-            cout << p1->name() << "'s board before the attack: " << endl;
-            b1.display(p2->isHuman());                                                  // display p1 board
             
-            Point recomended = p2->recommendAttack();                                   // p2 recomends attack
-            bool failtest = b1.attack(recomended, shotHit, shipDestroyed, shipId);      // p2 attacks
-            while (!failtest) {
-                p2->recordAttackResult(recomended, 0, shotHit, shipDestroyed, shipId);  // p2 records his failed attack
-                recomended = p2->recommendAttack();                                     // re-recomending and attacking
-                failtest = b1.attack(recomended, shotHit, shipDestroyed, shipId);       // if previous attack was invalid
+        case ATTACKING: {
+            // end criteria, one board has all ships destroyed
+            if (boards[0]->allShipsDestroyed() || boards[1]->allShipsDestroyed()) {return conclude(nullptr);}
+            Player* attacker = players[to_move];
+            Player* defender = players[1 - to_move];
+            if (salvo_shots != 1) {                                                     // a salvo game takes turns the same way
+                salvo_size = salvo_shots == SALVO_ONE_PER_SHIP ? afloat[to_move] : salvo_shots;
+                cout << attacker->name() << "'s turn to fire a salvo of " << salvo_size << endl;
+                cout << defender->name() << "'s board before the salvo: " << endl;
+            }
+            else {
+                cout << attacker->name() << "'s turn to attack" << endl;
+                cout << defender->name() << "'s board before the attack: " << endl;
             }
+            boards[1 - to_move]->display(attacker->isHuman());                          // display the defender's board
             
-            cout << p1->name() << "'s board after the attack: " << endl;
-            b1.display(p2->isHuman());                                                  // display p1 board
-            p2->recordAttackResult(recomended, 1, shotHit, shipDestroyed, shipId);      // p2 records his attack
-            p1->recordAttackByOpponent(recomended);                                     // p1 records the attack
-            whoseTurn = 1;                                                              // changing turns
-            cout << endl;
+            start_clock(to_move);                                                       // the attacker's clock runs for its move
+            if (salvo_shots != 1) { attacker->requestSalvo(static_cast<int>(salvo_size));}
+            else                  { attacker->requestAttack();}
+            phase = AWAITING;
+            return GAME_STEPPED;
+        }
+            
+        case AWAITING: {
+            Point recomended;
+            vector<Point> targets;
+            bool ready = salvo_shots != 1 ? players[to_move]->pollSalvo(static_cast<int>(salvo_size), targets)
+                                          : players[to_move]->pollAttack(recomended);
+            if (ready) {return salvo_shots != 1 ? salvo_landed(targets) : attack_landed(recomended);}
+            if (!out_of_time(to_move, clock_elapsed(to_move))) {return GAME_WAITING;}
+            record_move(to_move, stop_clock(to_move));                                  // the attacker lost on time
+            return conclude(players[to_move]);
         }
     }
+    return GAME_OVER;
+}
+
+GameStep GameImpl::attack_landed(Point p) {
+    // the attacker's one attack of the turn is in. If the board won't take it, the attacker hears so and is asked again
+    int which = to_move;
+    Player* attacker = players[which];
+    Player* defender = players[1 - which];
+    Board& b = *boards[1 - which];
+    bool shotHit = false;
+    bool shipDestroyed = false;
+    int  shipId = -1;
+    bool failtest = b.attack(p, shotHit, shipDestroyed, shipId);
+    if (!failtest && !out_of_time(which, clock_elapsed(which))) {
+        attacker->recordAttackResult(p, 0, shotHit, shipDestroyed, shipId);   // the attacker records its failed attack
+        attacker->requestAttack();                                              // and re-recomends
+        return GAME_STEPPED;
+    }
+    if (failtest) {
+        cout << defender->name() << "'s board after the attack: " << endl;
+        b.display(attacker->isHuman());
+        attacker->recordAttackResult(p, 1, shotHit, shipDestroyed, shipId);   // the attacker records its attack
+    }
+    record_move(which, stop_clock(which));
+    if (clocks[which].times.flagged) {return conclude(attacker);}             // the attacker lost on time
+    start_clock(1 - which);
+    defender->recordAttackByOpponent(p);                                        // the defender records the attack
+    stop_clock(1 - which);
+    if (out_of_time(1 - which, 0)) { clocks[1 - which].times.flagged = true; return conclude(defender);}
+    return end_turn();
+}
+
+GameStep GameImpl::salvo_landed(vector<Point>& targets) {
+    /*
+     the attacker's salvo is in: all the shots land, and only then does it hear the results.
+     A shot the board rejects is wasted rather than asked for again, since the attacker can't tell it was bad
+     until the whole salvo is over
+     */
+    int which = to_move;
+    Player* attacker = players[which];
+    Player* defender = players[1 - which];
+    Board& b = *boards[1 - which];
+    if (targets.size() > salvo_size) { targets.resize(salvo_size);}
+    vector<ShotResult> results;
+    b.attackSalvo(targets, results);
+    cout << defender->name() << "'s board after the salvo: " << endl;
+    b.display(attacker->isHuman());
+    attacker->recordSalvoResult(results);
+    record_move(which, stop_clock(which));
+    if (clocks[which].times.flagged) {return conclude(attacker);}
     
-    
-    
+    start_clock(1 - which);
+    for (size_t i = 0, N = results.size(); i < N; ++i) {
+        if (!results[i].validShot) {continue;}
+        defender->recordAttackByOpponent(results[i].p);
+        if (results[i].shipDestroyed) { --afloat[1 - which];}
+    }
+    stop_clock(1 - which);
+    if (out_of_time(1 - which, 0)) { clocks[1 - which].times.flagged = true; return conclude(defender);}
+    return end_turn();
+}
+
+GameStep GameImpl::end_turn() {
+    ++turns[to_move];
+    if (to_move == 0 && turns[0] > nRows * nCols) {return end_game(nullptr);}    // break condition
+    cout << endl;
+    if (!one_sided) { to_move = 1 - to_move;}                                   // changing turns
+    phase = ATTACKING;
+    return GAME_STEPPED;
+}
+
+GameStep GameImpl::conclude(Player* timed_out) {
     // Game Conclusion: announce winner, display winner's board if loser is human
+    Player* p1 = players[0];
+    Player* p2 = players[1];
     Player* winner = nullptr;
-    if (b1.allShipsDestroyed()) {
+    if (timed_out != nullptr) {
+        winner = (timed_out == p1 ? p2 : p1);
+        lastTurns = (winner == p1 ? turns[0] : turns[1]);
+        cout << timed_out->name() << " ran out of time. " << winner->name() << " Wins in " << lastTurns << " turns." << endl;
+    }
+    else if (boards[0]->allShipsDestroyed()) {
         winner = p2;
-        cout << p1->name() << " has no remaining ships. " << p2->name() <<" Wins in " << turn_counter << " turns."<< endl;
+        lastTurns = turns[1];
+        cout << p1->name() << " has no remaining ships. " << p2->name() <<" Wins in " << turns[1] << " turns."<< endl;
         if (p1->isHuman()) {
-            b2.display(0);
+            boards[1]->display(0);
         }
     }
     else {
         winner = p1;
-        cout << p2->name() << " has no remaining ships. " << p1->name() <<" Wins in " << turn_counter << " turns."<< endl;
+        lastTurns = turns[0];
+        cout << p2->name() << " has no remaining ships. " << p1->name() <<" Wins in " << turns[0] << " turns."<< endl;
         if (p2->isHuman()) {
-            b1.display(0);
+            boards[0]->display(0);
         }
     }
     cout << endl;
@@ -164,7 +419,16 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
     cout << "Thanks for playing :)" << endl;
     cout << "               - Kyle " << endl << endl;
     cout << "P.S. Remember to delete your players. "<< endl << endl << endl << endl;
-    return winner;
+    return end_game(winner);
+}
+
+GameStep GameImpl::end_game(Player* winner) {
+    the_winner = winner;
+    phase = FINISHED;
+    delete boards[0];
+    delete boards[1];
+    boards[0] = boards[1] = nullptr;
+    return GAME_OVER;
 }
 
 
@@ -233,6 +497,24 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
+    return addShip(ShipShape::straight(length), symbol, name);
+}
+
+bool Game::addShip(const vector<Point>& shape, char symbol, string name)
+{
+      // The shape is the ship's cells, which must be joined side to side,
+      // in any position: it will be turned and flipped every way there is.
+    if (!ShipShape::is_polyomino(shape))
+    {
+        cout << "Bad ship shape; its cells must be distinct and joined side to side" << endl;
+        return false;
+    }
+    ShipShape s(shape, rows(), cols());
+    if (s.placements() == 0)
+    {
+        cout << "Bad ship shape; it won't fit on the board" << endl;
+        return false;
+    }
     if (!isascii(symbol)  ||  !isprint(symbol))
     {
         cout << "Unprintable character with decimal value " << symbol
@@ -245,23 +527,18 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
-    int totalOfLengths = 0;
-    for (int s = 0; s < nShips(); s++)
+    if (fleet().shipId(symbol) >= 0)
     {
-        totalOfLengths += shipLength(s);
-        if (shipSymbol(s) == symbol)
-        {
-            cout << "Ship symbol " << symbol
-                 << " must not be used for more than one ship" << endl;
-            return false;
-        }
+        cout << "Ship symbol " << symbol
+             << " must not be used for more than one ship" << endl;
+        return false;
     }
-    if (totalOfLengths + length > rows() * cols())
+    if (fleet().totalLength + s.size() > rows() * cols())
     {
         cout << "Board is too small to fit all ships" << endl;
         return false;
     }
-    return m_impl->addShip(length, symbol, name);
+    return m_impl->addShip(s, symbol, name);
 }
 
 int Game::nShips() const
@@ -287,12 +564,120 @@ string Game::shipName(int shipId) const
     return m_impl->shipName(shipId);
 }
 
+const Fleet& Game::fleet() const
+{
+    return m_impl->fleet();
+}
+
+const ShipShape& Game::shipShape(int shipId) const
+{
+    assert(shipId >= 0  &&  shipId < nShips());
+    return m_impl->shipShape(shipId);
+}
+
+int Game::turnsTaken() const
+{
+    return m_impl->turnsTaken();
+}
+
+void Game::setTimeControl(const TimeControl& tc)
+{
+    m_impl->setTimeControl(tc);
+}
+
+TimeControl Game::timeControl() const
+{
+    return m_impl->timeControl();
+}
+
+double Game::timeRemaining(const Player* p) const
+{
+    return m_impl->timeRemaining(p);
+}
+
+double Game::moveTimeRemaining(const Player* p) const
+{
+    return m_impl->moveTimeRemaining(p);
+}
+
+MoveTimes Game::moveTimes(const Player* p) const
+{
+    return m_impl->moveTimes(p);
+}
+
+void Game::setSalvo(int shotsPerTurn)
+{
+    m_impl->setSalvo(shotsPerTurn);
+}
+
+int Game::salvo() const
+{
+    return m_impl->salvo();
+}
+
+void Game::setOneSided(bool oneSided)
+{
+    m_impl->setOneSided(oneSided);
+}
+
+bool Game::oneSided() const
+{
+    return m_impl->oneSided();
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
 {
-    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+      // the whole game in one call
+    if (!start(p1, p2, shouldPause))
         return nullptr;
-    Board b1(*this);
-    Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    return finish();
+}
+
+Player* Game::finish()
+{
+      // step the game to its end, waiting whenever a player is.
+      // A wait goes like bot_wait's (see BotProtocol.h): yielding for the
+      // first millisecond, in case the answer is nearly there, then sleeping
+      // 50 microseconds at a time, so a slow player doesn't cost a whole core
+    GameStep s;
+    bool waiting = false;
+    chrono::steady_clock::time_point waitingSince;
+    while ((s = step()) != GAME_OVER)
+    {
+        if (s != GAME_WAITING)
+        {
+            waiting = false;
+            continue;
+        }
+        auto now = chrono::steady_clock::now();
+        if (!waiting)
+        {
+            waiting = true;
+            waitingSince = now;
+        }
+        if (now - waitingSince < chrono::milliseconds(1))
+            this_thread::yield();
+        else
+            this_thread::sleep_for(chrono::microseconds(50));
+    }
+    return winner();
+}
+
+bool Game::start(Player* p1, Player* p2, bool shouldPause)
+{
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+        return false;
+    m_impl->start(p1, p2, new Board(*this), new Board(*this), shouldPause);
+    return true;
+}
+
+GameStep Game::step()
+{
+    return m_impl->step();
+}
+
+Player* Game::winner() const
+{
+    return m_impl->winner();
 }
 
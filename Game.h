@@ -2,11 +2,52 @@
 #define GAME_INCLUDED
 
 #include <string>
+#include <vector>
 #include <cassert>
 
 class Point;
 class Player;
 class GameImpl;
+class ShipShape;
+
+  // A chess style clock for each player (all times in milliseconds, 0 for no limit).
+  // A player who goes over the move limit or runs out of budget loses the game on time.
+struct TimeControl
+{
+    double moveMillis;          // the most one attack may take
+    double totalMillis;         // the player's budget for the whole game
+    double incrementMillis;     // added to the budget after each attack
+};
+
+  // For setSalvo: each turn a player fires one shot for each of its own ships still afloat
+const int SALVO_ONE_PER_SHIP = 0;
+
+  // How long a player's attacks took in the most recent game (or the one being played)
+struct MoveTimes
+{
+    long moves;
+    double totalMillis;
+    double maxMillis;
+    bool flagged;               // lost on time
+};
+
+  // What Game::step did: took the game on a step, found it waiting on a player
+  // (step again later; nothing will happen in between), or found it over
+enum GameStep { GAME_STEPPED, GAME_WAITING, GAME_OVER };
+
+  // The fleet laid out flat, for code that looks ships up in its inner loops (Board, Possibilities_Board).
+  // The Game keeps it up to date as ships are added, at the same address for as long as the Game lasts,
+  // so a reference taken once stays good. The shapes belong to the Game
+struct Fleet
+{
+    int nShips;
+    int totalLength;                        // of all the ships
+    std::vector<int> lengths;
+    std::vector<char> symbols;
+    std::vector<const ShipShape*> shapes;   // each with every placement's mask (see ShipShape.h)
+    int idOf[256];                          // the shipId with each symbol, -1 for none
+    int shipId(char symbol) const { return idOf[static_cast<unsigned char>(symbol)];}
+};
 
 class Game
 {
@@ -18,11 +59,37 @@ class Game
     bool isValid(Point p) const;
     Point randomPoint() const;
     bool addShip(int length, char symbol, std::string name);
+    bool addShip(const std::vector<Point>& shape, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
+    const ShipShape& shipShape(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
+    const Fleet& fleet() const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+      // play a step at a time: start, then step until GAME_OVER, then winner
+      // (nullptr if the game couldn't be played to the end). Since a waiting
+      // step returns at once, one thread can keep many games going together
+    bool start(Player* p1, Player* p2, bool shouldPause = true);
+    GameStep step();
+    Player* winner() const;
+      // the rest of a started game in one call, waiting on players the way
+      // play does (play is just start, then finish); returns the winner
+    Player* finish();
+    int turnsTaken() const;
+    void setTimeControl(const TimeControl& tc);
+    TimeControl timeControl() const;
+    double timeRemaining(const Player* p) const;
+    double moveTimeRemaining(const Player* p) const;
+    MoveTimes moveTimes(const Player* p) const;
+    void setSalvo(int shotsPerTurn);
+    int salvo() const;
+      // In a one sided game only the first player attacks: the second places
+      // its ships and hears the attacks, but is never asked for one, so the
+      // game goes on until the first player has sunk every ship (or runs out
+      // of turns or time). It measures how fast a player finds a layout
+    void setOneSided(bool oneSided);
+    bool oneSided() const;
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
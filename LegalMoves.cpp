@@ -0,0 +1,74 @@
+//
+//  LegalMoves.cpp
+//  Battleship
+//
+
+#include "LegalMoves.h"
+#include "Game.h"
+
+using namespace std;
+
+LegalMoves::LegalMoves(const Game& g) : rows(g.rows()), cols(g.cols()), state(g.rows()*g.cols(), UNTRIED), position(g.rows()*g.cols()) {
+    for (int i = 0, N = rows*cols; i < N; ++i) {
+        int parity = (i / cols + i % cols) % 2;
+        position[i] = static_cast<int>(dense[parity].size());
+        dense[parity].push_back(i);
+    }
+}
+
+void LegalMoves::record(Point p, bool hit) {
+    if (!is_untried(p)) {return;}
+    int cell = cols * p.r + p.c;
+    state[cell] = hit ? HIT : MISSED;
+    
+    // swap the last cell of the list into the removed cell's spot
+    vector<int>& list = dense[(p.r + p.c) % 2];
+    int moved = list.back();
+    list[position[cell]] = moved;
+    position[moved] = position[cell];
+    list.pop_back();
+    position[cell] = -1;
+}
+
+bool LegalMoves::is_untried(Point p) const {
+    if (p.r < 0 || p.r >= rows || p.c < 0 || p.c >= cols) {return false;}
+    return state[cols * p.r + p.c] == UNTRIED;
+}
+
+bool LegalMoves::is_hit(Point p) const {
+    if (p.r < 0 || p.r >= rows || p.c < 0 || p.c >= cols) {return false;}
+    return state[cols * p.r + p.c] == HIT;
+}
+
+int LegalMoves::untried_count() const { return static_cast<int>(dense[0].size() + dense[1].size());}
+
+int LegalMoves::untried_count(int parity) const { return static_cast<int>(dense[parity % 2].size());}
+
+Point LegalMoves::random_untried() const {
+    // falls back to (0, 0) only if every cell has been tried, when no shot would be legal anyway
+    int n_even = untried_count(0);
+    int n = untried_count();
+    if (n == 0) {return Point(0, 0);}
+    int k = randInt(n);
+    int cell = k < n_even ? dense[0][k] : dense[1][k - n_even];
+    return Point(cell / cols, cell % cols);
+}
+
+Point LegalMoves::random_untried(int parity) const {
+    const vector<int>& list = dense[parity % 2];
+    if (list.empty()) {return random_untried();}
+    int cell = list[randInt(static_cast<int>(list.size()))];
+    return Point(cell / cols, cell % cols);
+}
+
+bool LegalMoves::line_of_fire(Point from, Point step, Point& target) const {
+    /*
+     walks from `from` (not included) in the direction of `step`, passing over cells we've hit,
+     and gives back the first untried cell; returns false if a miss or the edge of the board comes first
+     */
+    Point p(from.r + step.r, from.c + step.c);
+    while (is_hit(p)) { p = Point(p.r + step.r, p.c + step.c);}
+    if (!is_untried(p)) {return false;}
+    target = p;
+    return true;
+}
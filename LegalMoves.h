@@ -0,0 +1,45 @@
+//
+//  LegalMoves.h
+//  Battleship
+//
+
+#ifndef LEGALMOVES_INCLUDED
+#define LEGALMOVES_INCLUDED
+
+#include "globals.h"
+#include <vector>
+
+/*
+ LegalMoves keeps track of which cells of the opponent's board a player hasn't attacked yet,
+ so a player can always recommend a shot that Board::attack will accept on the first try.
+
+ The untried cells are kept in a sparse set, split by parity ((r + c) % 2):
+ each parity has a dense list of its untried cells, and every cell remembers where it sits in that list.
+ Removing a cell swaps it with the last one in its list, so recording a shot,
+ checking a cell, and drawing a random untried cell (of either parity) are all O(1).
+ */
+
+class Game;
+
+class LegalMoves
+{
+  public:
+    LegalMoves(const Game& g);
+    void record(Point p, bool hit);
+    bool is_untried(Point p) const;
+    bool is_hit(Point p) const;
+    int untried_count() const;
+    int untried_count(int parity) const;
+    Point random_untried() const;
+    Point random_untried(int parity) const;
+    bool line_of_fire(Point from, Point step, Point& target) const;
+  private:
+    enum Cell { UNTRIED, MISSED, HIT };
+    int rows;
+    int cols;
+    std::vector<char> state;
+    std::vector<int> position;   // where each untried cell sits in its parity's dense list
+    std::vector<int> dense[2];   // untried cells of each parity
+};
+
+#endif // LEGALMOVES_INCLUDED
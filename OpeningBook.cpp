@@ -0,0 +1,381 @@
+//
+//  OpeningBook.cpp
+//  Battleship
+//
+
+#include "OpeningBook.h"
+#include "Game.h"
+#include "Possibilities.h"
+#include "ShipShape.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ The file, all numbers little endian:
+     "BSOB", version (4 bytes), rows, cols, depth (1 byte each), 5 spare bytes,
+     the fleet fingerprint (8), samples per position (8), number of entries (8), and zeros up to 64 bytes,
+ then the entries, 32 bytes each, sorted by their shot lists (compared byte by byte):
+     the canonical position's shots as (cell, result) pairs in cell order, padded with 0xFF, then the best cell and the shot count.
+ Cells are r * cols + c, which always fits in a byte since MAXCELLS is small.
+ */
+
+const uint32_t BOOK_VERSION = 1;
+const size_t BOOK_HEADER_SIZE = 64;
+const size_t BOOK_KEY_SIZE = 2 * BOOK_MAX_SHOTS;
+
+struct BookEntry
+{
+    uint8_t shots[BOOK_KEY_SIZE];
+    uint8_t best;
+    uint8_t n_shots;
+};
+
+static_assert(sizeof(BookEntry) == 32, "book entries are 32 bytes in the file");
+static_assert(MAXCELLS < 0xFF, "a cell has to fit in a byte, with 0xFF left over for padding");
+
+
+//*********************************************************************
+//  Symmetries
+//*********************************************************************
+
+static int n_symmetries(int rows, int cols) { return rows == cols ? 8 : 4;}
+
+// symmetry t: transpose if bit 2 is set (square boards only), then flip the rows if bit 0 is set and the columns if bit 1 is
+static int transform_cell(int t, int cell, int rows, int cols) {
+    int r = cell / cols, c = cell % cols;
+    if (t & 4) { swap(r, c);}
+    if (t & 1) { r = rows - 1 - r;}
+    if (t & 2) { c = cols - 1 - c;}
+    return r * cols + c;
+}
+
+static int untransform_cell(int t, int cell, int rows, int cols) {
+    int r = cell / cols, c = cell % cols;
+    if (t & 2) { c = cols - 1 - c;}
+    if (t & 1) { r = rows - 1 - r;}
+    if (t & 4) { swap(r, c);}
+    return r * cols + c;
+}
+
+static bool canonical_key(const vector<uint8_t>& position, int rows, int cols, uint8_t key[BOOK_KEY_SIZE], int& transform) {
+    /*
+     writes the canonical form of the position into key, and which symmetry takes the position to it into transform.
+     false if the position has more shots than an entry can hold
+     */
+    vector<pair<int, int>> shots;
+    for (size_t i = 0, N = position.size(); i < N; ++i) {
+        if (position[i] != BOOK_UNKNOWN) { shots.push_back(make_pair(static_cast<int>(i), position[i]));}
+    }
+    if (shots.size() > static_cast<size_t>(BOOK_MAX_SHOTS)) {return false;}
+
+    uint8_t candidate[BOOK_KEY_SIZE];
+    vector<pair<int, int>> moved(shots.size());
+    for (int t = 0, N = n_symmetries(rows, cols); t < N; ++t) {
+        for (size_t i = 0, M = shots.size(); i < M; ++i) {
+            moved[i] = make_pair(transform_cell(t, shots[i].first, rows, cols), shots[i].second);
+        }
+        sort(moved.begin(), moved.end());
+        memset(candidate, 0xFF, BOOK_KEY_SIZE);
+        for (size_t i = 0, M = moved.size(); i < M; ++i) {
+            candidate[2*i] = static_cast<uint8_t>(moved[i].first);
+            candidate[2*i + 1] = static_cast<uint8_t>(moved[i].second);
+        }
+        if (t == 0 || memcmp(candidate, key, BOOK_KEY_SIZE) < 0) {
+            memcpy(key, candidate, BOOK_KEY_SIZE);
+            transform = t;
+        }
+    }
+    return true;
+}
+
+uint64_t fleet_fingerprint(const Game& g) {
+    // FNV-1a over the board size and each ship's cells, in shipId order since the book's sunk results name ships by id
+    uint64_t h = 0xcbf29ce484222325ULL;
+    auto mix = [&h](int x) { h = (h ^ static_cast<uint64_t>(x & 0xFF)) * 0x100000001b3ULL;};
+    mix(g.rows());
+    mix(g.cols());
+    mix(g.nShips());
+    for (int s = 0, N = g.nShips(); s < N; ++s) {
+        const vector<Point>& cells = g.shipShape(s).cells(0);
+        mix(static_cast<int>(cells.size()));
+        for (size_t i = 0, M = cells.size(); i < M; ++i) { mix(cells[i].r); mix(cells[i].c);}
+    }
+    return h;
+}
+
+
+//*********************************************************************
+//  OpeningBook
+//*********************************************************************
+
+static uint64_t read_le(const uint8_t* p, int nBytes) {
+    uint64_t x = 0;
+    for (int i = 0; i < nBytes; ++i) { x |= static_cast<uint64_t>(p[i]) << (8*i);}
+    return x;
+}
+
+OpeningBook::OpeningBook() : mapped(nullptr), mapped_size(0), entries(nullptr), n_entries(0), depth(0), rows(0), cols(0), fingerprint(0) {}
+
+OpeningBook::~OpeningBook() { close();}
+
+bool OpeningBook::open(const string& path) {
+    // maps the book file, false (and no book) if it is missing, isn't a book, or is cut short
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {return false;}
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < BOOK_HEADER_SIZE) { ::close(fd); return false;}
+    size_t size = static_cast<size_t>(st.st_size);
+    void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {return false;}
+
+    const uint8_t* header = static_cast<const uint8_t*>(m);
+    uint64_t count = read_le(header + 32, 8);
+    if (memcmp(header, "BSOB", 4) != 0 || read_le(header + 4, 4) != BOOK_VERSION ||
+        count > (size - BOOK_HEADER_SIZE) / sizeof(BookEntry) || size != BOOK_HEADER_SIZE + count * sizeof(BookEntry)) {
+        munmap(m, size);
+        return false;
+    }
+    mapped = m;
+    mapped_size = size;
+    rows = header[8];
+    cols = header[9];
+    depth = header[10];
+    fingerprint = read_le(header + 16, 8);
+    n_entries = static_cast<long>(count);
+    entries = header + BOOK_HEADER_SIZE;
+    return true;
+}
+
+void OpeningBook::close() {
+    if (mapped != nullptr) { munmap(mapped, mapped_size);}
+    mapped = nullptr;
+    mapped_size = 0;
+    entries = nullptr;
+    n_entries = 0;
+}
+
+bool OpeningBook::is_for(const Game& g) const {
+    return is_open() && rows == g.rows() && cols == g.cols() && fingerprint == fleet_fingerprint(g);
+}
+
+bool OpeningBook::lookup(const Game& g, const vector<uint8_t>& position, Point& best) const {
+    // the book's shot for the position, turned back from the canonical form; false if the position isn't in the book
+    if (!is_open() || rows != g.rows() || cols != g.cols() || position.size() != static_cast<size_t>(rows * cols)) {return false;}
+    int shots = 0;
+    for (size_t i = 0, N = position.size(); i < N; ++i) {
+        if (position[i] != BOOK_UNKNOWN) {++shots;}
+    }
+    if (shots >= depth) {return false;}
+
+    uint8_t key[BOOK_KEY_SIZE];
+    int transform = 0;
+    if (!canonical_key(position, rows, cols, key, transform)) {return false;}
+    long lo = 0, hi = n_entries;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        int order = memcmp(entries + mid * sizeof(BookEntry), key, BOOK_KEY_SIZE);
+        if (order == 0) {
+            int cell = untransform_cell(transform, entries[mid * sizeof(BookEntry) + BOOK_KEY_SIZE], rows, cols);
+            best = Point(cell / cols, cell % cols);
+            return true;
+        }
+        if (order < 0) { lo = mid + 1;}
+        else           { hi = mid;}
+    }
+    return false;
+}
+
+const OpeningBook& OpeningBook::shared() {
+    // opened once, the first time anyone asks (a function static is set up safely even with several threads asking)
+    static OpeningBook book;
+    static bool opened = book.open("opening_book.bin");
+    (void)opened;
+    return book;
+}
+
+
+//*********************************************************************
+//  write_opening_book
+//*********************************************************************
+
+/*
+ The book is made by walking every way the game can start for a player that follows it.
+ At each position the samples say which cell is best (the one most often under a ship, as for GoodPlayer),
+ and which results a shot there can have: a miss, a hit, or sinking one ship or another.
+ Each result with any samples behind it is a new position, one shot deeper, until the book is `depth` shots deep.
+ The walk moves along with Possibilities_Board::make_shot and back with unmake_shot, so no board is ever rebuilt,
+ and a position already in the book (reached in another order, or turned or flipped) isn't walked again
+ */
+
+class BookWriter
+{
+  public:
+    BookWriter(const Game& g, int depth, long samples);
+    void walk(int shots);
+    vector<BookEntry> entries;
+  private:
+    void sample(vector<long>& counts, vector<long>& sinks, long& accepted) const;
+    const Game& m_game;
+    int n_cells;
+    int n_ships;
+    int depth;
+    long samples;
+    Possibilities_Board board;
+    vector<uint8_t> position;
+    vector<string> seen;        // canonical keys already in entries, kept sorted
+};
+
+BookWriter::BookWriter(const Game& g, int _depth, long _samples)
+ : m_game(g), n_cells(g.rows() * g.cols()), n_ships(g.nShips()), depth(_depth), samples(_samples), board(g),
+   position(g.rows() * g.cols(), BOOK_UNKNOWN) {
+    board.determine_locations();
+}
+
+void BookWriter::sample(vector<long>& counts, vector<long>& sinks, long& accepted) const {
+    /*
+     counts[c] is how many samples have a ship on unknown cell c,
+     sinks[c * n_ships + s] how many have ship s with c as its only unknown cell left, so a shot there sinks it.
+     The samples are split into chunks on the ThreadPool, the same as GoodPlayer's, each with its own generator
+     */
+    const size_t CHUNKS = 16;
+    CellSet unknown;
+    for (int i = 0; i < n_cells; ++i) { unknown[i] = position[i] == BOOK_UNKNOWN;}
+    vector<vector<long>> chunk_counts(CHUNKS, vector<long>(n_cells, 0));
+    vector<vector<long>> chunk_sinks(CHUNKS, vector<long>(n_cells * n_ships, 0));
+    vector<long> chunk_accepted(CHUNKS, 0);
+    const unsigned int chunk_seed = randomGenerator()();
+    {
+        TaskGroup group;
+        for (size_t k = 0; k < CHUNKS; ++k) {
+            long per_chunk = samples / CHUNKS + (static_cast<long>(k) < samples % static_cast<long>(CHUNKS) ? 1 : 0);
+            group.run([this, k, per_chunk, chunk_seed, &unknown, &chunk_counts, &chunk_sinks, &chunk_accepted] {
+                Possibilities_Board b(board);
+                mt19937 generator = taskGenerator(chunk_seed, static_cast<unsigned int>(k));
+                for (long i = 0; i < per_chunk; ++i) {
+                    if (b.place_ships(generator) && b.is_valid_board()) {
+                        ++chunk_accepted[k];
+                        for (int s = 0; s < n_ships; ++s) {
+                            CellSet cells = b.ship_cells(s) & unknown;
+                            int last = -1, left = 0;
+                            for (int c = 0; c < n_cells; ++c) {
+                                if (!cells[c]) {continue;}
+                                ++chunk_counts[k][c];
+                                last = c;
+                                ++left;
+                            }
+                            if (left == 1) { ++chunk_sinks[k][last * n_ships + s];}
+                        }
+                    }
+                    b.unplace_all_ships();
+                }
+            });
+        }
+        group.wait();
+    }
+    counts.assign(n_cells, 0);
+    sinks.assign(n_cells * n_ships, 0);
+    accepted = 0;
+    for (size_t k = 0; k < CHUNKS; ++k) {
+        for (int i = 0; i < n_cells; ++i) { counts[i] += chunk_counts[k][i];}
+        for (int i = 0; i < n_cells * n_ships; ++i) { sinks[i] += chunk_sinks[k][i];}
+        accepted += chunk_accepted[k];
+    }
+}
+
+void BookWriter::walk(int shots) {
+    if (shots >= depth) {return;}
+    BookEntry entry;
+    int transform = 0;
+    if (!canonical_key(position, m_game.rows(), m_game.cols(), entry.shots, transform)) {return;}
+    string key(reinterpret_cast<const char*>(entry.shots), BOOK_KEY_SIZE);
+    auto at = lower_bound(seen.begin(), seen.end(), key);
+    if (at != seen.end() && *at == key) {return;}               // already in the book
+
+    vector<long> counts, sinks;
+    long accepted = 0;
+    sample(counts, sinks, accepted);
+    int best = -1;
+    for (int c = 0; c < n_cells; ++c) {
+        if (position[c] == BOOK_UNKNOWN && counts[c] > 0 && (best < 0 || counts[c] > counts[best])) {best = c;}
+    }
+    if (best < 0) {return;}                                     // nothing sampled, so leave it to the player
+    entry.best = static_cast<uint8_t>(transform_cell(transform, best, m_game.rows(), m_game.cols()));
+    entry.n_shots = static_cast<uint8_t>(shots);
+    entries.push_back(entry);
+    seen.insert(at, key);
+
+    // every result a shot at best can have, one after another
+    Point p(best / m_game.cols(), best % m_game.cols());
+    long sunk = 0;
+    for (int s = 0; s < n_ships; ++s) {
+        if (sinks[best * n_ships + s] == 0) {continue;}
+        sunk += sinks[best * n_ships + s];
+        board.make_shot(p, 'X', s);
+        position[best] = static_cast<uint8_t>(BOOK_SUNK + s);
+        walk(shots + 1);
+        board.unmake_shot();
+    }
+    if (counts[best] > sunk) {
+        board.make_shot(p, 'X');
+        position[best] = BOOK_HIT;
+        walk(shots + 1);
+        board.unmake_shot();
+    }
+    if (accepted > counts[best]) {
+        board.make_shot(p, 'o');
+        position[best] = BOOK_MISS;
+        walk(shots + 1);
+        board.unmake_shot();
+    }
+    position[best] = BOOK_UNKNOWN;
+}
+
+static void write_le(FILE* f, uint64_t x, int nBytes) {
+    for (int i = 0; i < nBytes; ++i) { fputc(static_cast<int>((x >> (8*i)) & 0xFF), f);}
+}
+
+long write_opening_book(const Game& g, int depth, long samples, const string& path) {
+    /*
+     Like a tournament checkpoint, the book is written to a temporary file and renamed into place once it is complete,
+     so a book file that exists is a whole book
+     */
+    if (depth < 1 || depth > BOOK_MAX_SHOTS || samples < 1 || g.nShips() == 0 || BOOK_SUNK + g.nShips() > 0xFF) {return -1;}
+    BookWriter writer(g, depth, samples);
+    writer.walk(0);
+    vector<BookEntry>& entries = writer.entries;
+    sort(entries.begin(), entries.end(), [](const BookEntry& a, const BookEntry& b) {
+        return memcmp(a.shots, b.shots, BOOK_KEY_SIZE) < 0;
+    });
+
+    string temp = path + ".tmp";
+    FILE* f = fopen(temp.c_str(), "wb");
+    if (f == nullptr) {return -1;}
+    fwrite("BSOB", 1, 4, f);
+    write_le(f, BOOK_VERSION, 4);
+    write_le(f, g.rows(), 1);
+    write_le(f, g.cols(), 1);
+    write_le(f, depth, 1);
+    write_le(f, 0, 5);
+    write_le(f, fleet_fingerprint(g), 8);
+    write_le(f, samples, 8);
+    write_le(f, entries.size(), 8);
+    write_le(f, 0, BOOK_HEADER_SIZE - 40);
+    if (!entries.empty()) { fwrite(&entries[0], sizeof(BookEntry), entries.size(), f);}
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        remove(temp.c_str());
+        return -1;
+    }
+    return static_cast<long>(entries.size());
+}
@@ -0,0 +1,77 @@
+//
+//  OpeningBook.h
+//  Battleship
+//
+
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ GoodPlayer's first few shots only depend on the results of the shots before them,
+ and at the start of a game there aren't many ways those can have gone.
+ So rather than sampling them all over again every game, they can be worked out once, offline and with far more samples,
+ and looked up: that is the opening book.
+
+ A position is a player's own shots so far, each with its result (miss, hit, or the ship it sank).
+ Every layout can be turned and flipped into another layout that is just as likely
+ (each ship comes in every orientation, see ShipShape.h), so two positions that are the same turned or flipped
+ have the same best shot, turned or flipped the same way.
+ The book only stores one position for each of these groups, its canonical form:
+ of the board's symmetries (8 on a square board, 4 otherwise), the one whose shot list sorts first.
+
+ The file is made by write_opening_book, starting from the empty board and following every result
+ the samples say the book's shot can have, to a given number of shots. It is a small header and then
+ fixed size entries sorted by position, so open() just maps it into memory and lookup() is a binary search.
+ The header records which game (board size and fleet) the book is for, and a book for any other game is ignored.
+
+ shared() is the book GoodPlayer uses: opening_book.bin in the working directory, mapped the first time it is asked for.
+ */
+
+class Game;
+
+// how a cell of a position is recorded: unknown, missed, hit, or sunk (BOOK_SUNK + shipId)
+const uint8_t BOOK_UNKNOWN = 0;
+const uint8_t BOOK_MISS = 1;
+const uint8_t BOOK_HIT = 2;
+const uint8_t BOOK_SUNK = 3;
+const int BOOK_MAX_SHOTS = 15;      // the deepest position an entry can hold
+
+class OpeningBook
+{
+  public:
+    OpeningBook();
+    ~OpeningBook();
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return entries != nullptr;}
+    bool is_for(const Game& g) const;
+    long size() const { return n_entries;}
+    int max_shots() const { return depth;}
+    bool lookup(const Game& g, const std::vector<uint8_t>& position, Point& best) const;
+    static const OpeningBook& shared();
+      // We prevent an OpeningBook object from being copied or assigned
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+  private:
+    void* mapped;
+    size_t mapped_size;
+    const uint8_t* entries;
+    long n_entries;
+    int depth;
+    int rows;
+    int cols;
+    uint64_t fingerprint;
+};
+
+// a hash of the board size and every ship's shape, to tell which game a book was made for
+uint64_t fleet_fingerprint(const Game& g);
+
+// works out the book for g to `depth` shots with `samples` samples a position; returns the number of positions or -1
+long write_opening_book(const Game& g, int depth, long samples, const std::string& path);
+
+#endif // OPENINGBOOK_INCLUDED
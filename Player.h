@@ -1,9 +1,10 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include "globals.h"
 #include <string>
+#include <vector>
 
-class Point;
 class Board;
 class Game;
 
@@ -26,6 +27,21 @@ class Player
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // In a salvo game (see Game::setSalvo) a player picks n shots at once
+      // and hears all their results together. By default these just go
+      // through recommendAttack and recordAttackResult one shot at a time.
+    virtual std::vector<Point> recommendSalvo(int n);
+    virtual void recordSalvoResult(const std::vector<ShotResult>& results);
+      // A game played a step at a time (see Game::step) doesn't wait for an
+      // attack: it asks for one with requestAttack, then polls for it with
+      // pollAttack, which returns false until it's ready. By default nothing
+      // happens until the poll, which just calls recommendAttack (the same
+      // for a salvo of n, with recommendSalvo). A player that works its
+      // attack out elsewhere starts on it at the request instead.
+    virtual void requestAttack();
+    virtual bool pollAttack(Point& p);
+    virtual void requestSalvo(int n);
+    virtual bool pollSalvo(int n, std::vector<Point>& shots);
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -37,4 +53,26 @@ class Player
 
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+  // How many of a good player's attacks were certain hits, so it shot
+  // them without sampling (both 0 for any other kind of player)
+struct ForcedShots
+{
+    long attacks;
+    long forced;
+};
+
+ForcedShots forcedShots(const Player* p);
+
+  // How often a good player's sampling found every layout there was, so it
+  // counted each one once and stopped early, and how many layouts those were
+  // in all (see Possibilities_Board::sample; all 0 for any other kind of player)
+struct ExhaustedSamples
+{
+    long samplings;
+    long exhausted;
+    long layouts;
+};
+
+ExhaustedSamples exhaustedSamples(const Player* p);
+
 #endif // PLAYER_INCLUDED
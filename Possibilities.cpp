@@ -7,14 +7,22 @@
 
 #include "Board.h"
 #include "Game.h"
+#include "ShipShape.h"
 #include "Possibilities.h"
+#include "ThreadPool.h"
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
 
 using namespace std;
 
-Possibilities_Board::Possible_Location::Possible_Location(Point _topOrLeft, int _shipId, Direction _dir) :
-     topOrLeft(_topOrLeft), shipId(_shipId), dir(_dir) {};
+Possibilities_Board::Possible_Location::Possible_Location(int _shipId, const ShipPlacement* _placement) :
+     shipId(_shipId), placement(_placement) {};
 
 
 //*********************************************************************
@@ -22,31 +30,47 @@ Possibilities_Board::Possible_Location::Possible_Location(Point _topOrLeft, int
 //*********************************************************************
 
 
-Possibilities_Board::Possibilities_Board(const Game& g) : m_game(g), locations_list(g.nShips(), vector<Possible_Location>()), board(g.rows()*g.cols(), '.') {
+Possibilities_Board::Possibilities_Board(const Game& g)
+ : m_game(g), m_fleet(g.fleet()), destroyed(g.nShips(), 0), locations_list(g.nShips(), vector<Possible_Location>()), n_locations(g.nShips(), 0),
+   choices(g.nShips()), tries_left(0) {
+    assignments.assigned = 0;
+    assignments.too_many = false;
+    board.ships.resize(g.nShips());
     refrence_board = board;
 };
 
 void Possibilities_Board::update(Point p, char c) {
-    board[m_game.cols() * p.r + p.c] = c;
-    refrence_board[m_game.cols() * p.r + p.c] = c;
+    size_t cell = m_game.cols() * p.r + p.c;
+    if (c == 'o')      { misses.set(cell);}
+    else if (c == 'X') { refrence_board.hits.set(cell);}
+    else {
+        int s = m_fleet.shipId(c);
+        if (s >= 0) {
+            refrence_board.hits.reset(cell);
+            refrence_board.taken.set(cell);
+            refrence_board.ships[s].set(cell);
+        }
+    }
+    board = refrence_board;
 }
 
 void Possibilities_Board::ship_destroyed(int shipId) {
+    if (shipId < 0 || shipId >= m_fleet.nShips || destroyed[shipId]) {return;}
     destroyed_ships.push_back(shipId);
+    destroyed[shipId] = 1;
 }
 
 bool Possibilities_Board::is_ship_destroyed(int shipId) const{
-    for (size_t i = 0, N = destroyed_ships.size(); i < N; ++i) {
-        if (shipId == destroyed_ships[i]) {return true;}
-    }
-    return false;
+    return shipId >= 0 && shipId < m_fleet.nShips && destroyed[shipId];
 }
 
 
 void Possibilities_Board::read_to(vector<int> &data) const{
-    if (board.size() != data.size()) {return;}
+    // counts the cells a ship was placed on this time that were unknown ('.') on the refrence board (placed_cells)
+    if (static_cast<size_t>(m_game.rows() * m_game.cols()) != data.size()) {return;}
+    CellSet placed = placed_cells();
     for (size_t i = 0, N = data.size(); i < N; ++i) {
-        if (!(board[i] == 'o' || board[i] == '.') && (refrence_board[i] == '.')) {++data[i];}
+        if (placed[i]) {++data[i];}
     }
 }
 
@@ -59,26 +83,220 @@ void Possibilities_Board::determine_locations() {
      and the ship is permenantly placed on the board
      to provide more accuracy in calculating other ships' locations
      */
-    for (size_t i = 0, N = m_game.nShips(); i < N; ++i) {
-        if (locations_list[i].size() == 1) {            // if there was only one option from the last one,
+    for (size_t i = 0, N = m_fleet.nShips; i < N; ++i) {
+        if (n_locations[i] == 1) {                      // if there was only one option from the last one,
             if (is_valid(locations_list[i][0])) {       // ensure that it is a valid option
                 continue;                               // and skip to the next ship if it is
             }
         }
         locations_list[i].clear();                      // ensure that the vector is empty at the start
         int shipId = static_cast<int>(i);
-        for (size_t i = 0, N = board.size(); i < N; ++i) {
-            Point p(static_cast<int>(i) / m_game.cols(), static_cast<int>(i) % m_game.cols());
-            Possible_Location LH(p, shipId, HORIZONTAL);
-            if (is_valid(LH)) { locations_list[shipId].push_back(LH);}
-            Possible_Location LV(p, shipId, VERTICAL);
-            if (is_valid(LV)) { locations_list[shipId].push_back(LV);}
+        const ShipShape& shape = *m_fleet.shapes[shipId];
+        for (int k = 0, N = shape.placements(); k < N; ++k) {
+            Possible_Location L(shipId, &shape.placement(k));
+            if (is_valid(L)) { locations_list[shipId].push_back(L);}
         }
-        if (locations_list[i].size() == 1) {            // in the case of only one option, force it into the refrence board
+        n_locations[i] = locations_list[i].size();
+        if (n_locations[i] == 1) {            // in the case of only one option, force it into the refrence board
             place_ship(locations_list[i][0]);           // this will save time in later calls to determine_location()
             refrence_board = board;
         }
     }
+    update_sunk_assignments();
+    order_ships();
+}
+
+CellSet Possibilities_Board::certain_cells() const {
+    /*
+     certain_cells finds the cells that are under a ship in every layout still possible, without sampling any.
+     Every ship is in one of its locations, so a cell all of a ship's locations cover is certain,
+     which covers a ship with only one location left.
+     And every hit no ship has been fixed on yet has to be under one of the locations (of any ship) that cover it,
+     so a cell all of those cover is certain too, like the one cell left next to a hit boxed in on the other sides.
+     Shot cells come out as well (GoodPlayer only wants the unshot ones); call determine_locations first
+     */
+    CellSet certain;
+    for (size_t s = 0, N = m_fleet.nShips; s < N; ++s) {
+        if (n_locations[s] == 0) {continue;}
+        CellSet all = locations_list[s][0].placement->mask;
+        for (size_t k = 1; k < n_locations[s]; ++k) { all &= locations_list[s][k].placement->mask;}
+        certain |= all;
+    }
+    for (size_t cell = 0, N = m_game.rows() * m_game.cols(); cell < N; ++cell) {
+        if (!refrence_board.hits[cell]) {continue;}
+        CellSet all;
+        all.set();
+        bool covered = false;
+        for (size_t s = 0, M = m_fleet.nShips; s < M; ++s) {
+            for (size_t k = 0; k < n_locations[s]; ++k) {
+                const CellSet& mask = locations_list[s][k].placement->mask;
+                if (mask[cell]) { all &= mask; covered = true;}
+            }
+        }
+        if (covered) { certain |= all;}
+    }
+    return certain;
+}
+
+void Possibilities_Board::read_density(vector<double>& density, double hitWeight) const {
+    /*
+     read_density is the cheap estimate: no layouts at all, just each ship on its own.
+     A ship is equally likely to be at any of its locations, except that a location over hits nothing explains yet
+     counts hitWeight times as much for each one (those hits have to be under some ship, so it's far likelier),
+     and a cell's density is the chance each ship is on it, added up over the ships (so at most 1 if they never overlapped).
+     Ships do overlap here, and nothing makes sure every hit is covered, so it's rougher than sampling,
+     but it only walks the lists determine_locations made, which takes microseconds.
+     Like certain_cells, shot cells come out as well; call determine_locations first
+     */
+    size_t n_cells = m_game.rows() * m_game.cols();
+    density.assign(n_cells, 0.0);
+    vector<double> ship(n_cells);
+    for (size_t s = 0, N = m_fleet.nShips; s < N; ++s) {
+        if (n_locations[s] == 0) {continue;}
+        ship.assign(n_cells, 0.0);
+        double total = 0;
+        for (size_t k = 0; k < n_locations[s]; ++k) {
+            const ShipPlacement& L = *locations_list[s][k].placement;
+            double weight = 1;
+            for (size_t h = 0, H = (L.mask & refrence_board.hits).count(); h < H; ++h) { weight *= hitWeight;}
+            for (size_t i = 0, M = L.cells.size(); i < M; ++i) { ship[L.cells[i]] += weight;}
+            total += weight;
+        }
+        for (size_t i = 0; i < n_cells; ++i) { density[i] = min(1.0, density[i] + ship[i] / total);}
+    }
+}
+
+bool Possibilities_Board::sample(vector<int>& counts, size_t samples, double limitMillis, Sample_Report* report) const {
+    /*
+     sample is the whole Monte Carlo run: up to `samples` layouts, each read_to into counts, stopping early
+     once limitMillis have gone by (and then returning false). GoodPlayer samples this way to attack and to place its ships.
+     
+     It starts on this thread alone, looking for repeats: every layout that fits is hashed (layout_hash)
+     and kept with the number of times it has turned up. The chance that the next sample is a layout not seen yet
+     is about the number seen only once over the samples so far, so once none has been seen just once,
+     and the last QUIET_PER_LAYOUT samples for each layout seen (and at least MIN_QUIET) turned up nothing new,
+     those are taken to be all there are. A layout with chance w of turning up is missed that way about e^(-w * run)
+     of the time: two layouts at 0.9 and 0.1 never are, four with one at 0.01 are 0.6% of the time.
+     Then counts gets each of them once instead, scaled to the samples so far, and sampling stops.
+     That saves the rest of the samples, and it weighs every layout the same, which the samples don't (see Accuracy.h),
+     leaving out the ones that can't be (hits_alone).
+     With more than EXHAUST_LAYOUTS different layouts that won't happen in any useful time, so it stops looking.
+     
+     The rest of the samples are split into chunks that run as tasks on the shared ThreadPool,
+     each chunk with its own copy of the possibilities board and its own counts, which are added up at the end.
+     Idle cores pick up chunks, and on a single core they all simply run one after another inside group.wait().
+     Each chunk draws from its own generator (taskGenerator, seeded from this thread's), never the thread's,
+     so the samples are the same whichever threads the chunks land on.
+     report, if given, says what happened. Call determine_locations first
+     */
+    const size_t MIN_QUIET = 500;
+    const size_t QUIET_PER_LAYOUT = 16;
+    auto start = chrono::steady_clock::now();
+    auto elapsed = [start] { return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();};
+    Sample_Report r = {0, 0, false};
+    atomic<bool> out_of_time(false);
+    size_t tried = 0;
+    {
+        struct Seen
+        {
+            CellSet cells;      // placed_cells
+            bool possible;      // not hits_alone
+            size_t times;
+        };
+        unordered_map<uint64_t, Seen> seen;
+        vector<int> seen_counts(counts.size(), 0);
+        size_t once = 0;
+        size_t quiet = 0;       // samples since the last new layout
+        Possibilities_Board board(*this);
+        while (tried < samples && seen.size() <= EXHAUST_LAYOUTS && !r.exhausted) {
+            if (tried % 20 == 0 && elapsed() >= limitMillis) {out_of_time = true; break;}
+            ++tried;
+            if (!board.place_ships()) {continue;}
+            if (board.is_valid_board()) {
+                board.read_to(seen_counts);
+                ++r.accepted;
+                Seen& layout = seen[board.layout_hash()];
+                if (layout.times++ == 0) {
+                    layout.cells = board.placed_cells();
+                    layout.possible = !board.hits_alone();
+                    ++once;
+                    quiet = 0;
+                }
+                else {
+                    if (layout.times == 2) { --once;}
+                    ++quiet;
+                }
+                r.exhausted = once == 0 && quiet >= max(MIN_QUIET, QUIET_PER_LAYOUT * seen.size());
+            }
+            board.unplace_all_ships();
+        }
+        r.distinct = seen.size();
+        size_t possible = 0;
+        for (auto it = seen.begin(); it != seen.end(); ++it) { possible += it->second.possible;}
+        if (r.exhausted && possible > 0) {
+            // as if the samples so far had turned up each possible layout equally often
+            for (size_t i = 0, N = counts.size(); i < N; ++i) {
+                size_t covered = 0;
+                for (auto it = seen.begin(); it != seen.end(); ++it) { covered += it->second.possible && it->second.cells[i];}
+                counts[i] += static_cast<int>(lround(static_cast<double>(r.accepted) * covered / possible));
+            }
+        }
+        else {
+            for (size_t i = 0, N = counts.size(); i < N; ++i) { counts[i] += seen_counts[i];}
+        }
+    }
+    if (r.exhausted || out_of_time || tried >= samples) {
+        if (report != nullptr) { *report = r;}
+        return !out_of_time;
+    }
+    
+    const size_t CHUNKS = 16;
+    const size_t PER_CHUNK = (samples - tried + CHUNKS - 1) / CHUNKS;
+    const unsigned int chunk_seed = randomGenerator()();
+    vector<vector<int>> chunk_counts(CHUNKS, vector<int>(counts.size(), 0));
+    vector<size_t> chunk_accepted(CHUNKS, 0);
+    {
+        TaskGroup group;
+        for (size_t k = 0; k < CHUNKS; ++k) {
+            group.run([this, k, PER_CHUNK, chunk_seed, limitMillis, &chunk_counts, &chunk_accepted, &out_of_time, &elapsed] {
+                Possibilities_Board board(*this);
+                mt19937 generator = taskGenerator(chunk_seed, static_cast<unsigned int>(k));
+                size_t i = 0;
+                while (i < PER_CHUNK && !out_of_time) {
+                    if (i % 20 == 0) { // looking at the clock takes time itself, so only checking every 20 simulations
+                        if (elapsed() >= limitMillis) {out_of_time = true; break;}  // break if close to the time limit
+                    }
+                    if (!board.place_ships(generator)) {++i; continue;}             // recursion within possibilities, continue if failed
+                    if (board.is_valid_board()) {                                   // update board
+                        board.read_to(chunk_counts[k]);
+                        ++chunk_accepted[k];
+                    }
+                    ++i;
+                    board.unplace_all_ships();
+                }
+            });
+        }
+        group.wait();
+    }
+    for (size_t k = 0; k < CHUNKS; ++k) {
+        for (size_t i = 0, N = counts.size(); i < N; ++i) { counts[i] += chunk_counts[k][i];}
+        r.accepted += chunk_accepted[k];
+    }
+    if (report != nullptr) { *report = r;}
+    return !out_of_time;
+}
+
+bool Possibilities_Board::hits_alone() const {
+    /*
+     whether a ship afloat was placed this time on nothing but hits, which can't be: it would have been sunk.
+     Samples don't check this (see Accuracy.h), but sample leaves such layouts out when it counts them exactly.
+     A ship fixed on the refrence board by determine_locations isn't checked, since its hits aren't kept
+     */
+    for (size_t s = 0, N = board.ships.size(); s < N; ++s) {
+        if (destroyed[s] || refrence_board.ships[s].any()) {continue;}
+        if ((board.ships[s] & ~refrence_board.hits).none()) {return true;}
+    }
+    return false;
 }
 
 bool Possibilities_Board::is_valid_board() const {
@@ -86,21 +304,99 @@ bool Possibilities_Board::is_valid_board() const {
      bool isValid checks if the possibilities board is overall valid
      I.E., no 'X' character
      */
-    for (size_t i = 0, N = board.size(); i < N; ++i) {
-        if (board[i] == 'X') {return false;}
-    }
-    return true;
+    return board.hits.none();
 }
 
-bool Possibilities_Board::place_ships() {
-    bool success;
-    if (destroyed_ships.size() != 0) { success = place_ships_recursively(destroyed_ships[0], 1, 0);}
-    else { success = place_ships_recursively(0, 0, destroyed_ships.size() + 1);}
-    return success;
+bool Possibilities_Board::place_ships() { return place_ships(randomGenerator());}
+
+bool Possibilities_Board::place_ships(mt19937& generator) {
+    /*
+     the sunk ships go on first, all at once, as a random one of the sunk assignments, then the ships afloat one by one.
+     If the afloat ships can't fit around that choice, the sample just fails and the next one picks again.
+     A failed sample leaves the board as it found it. The random choices come from generator
+     */
+    tries_left = TRIES_PER_SHIP * m_fleet.nShips;
+    if (!destroyed_ships.empty() && !assignments.too_many) {
+        if (assignments.list.empty()) {return false;}
+        const Sunk_Assignment& a = assignments.list[randInt(static_cast<int>(assignments.list.size()), generator)];
+        for (size_t i = 0, N = a.locations.size(); i < N; ++i) {
+            if (!place_ship(a.locations[i])) { unplace_all_ships(); return false;}
+        }
+    }
+    if (place_ships_recursively(0, generator)) {return true;}
+    unplace_all_ships();
+    return false;
 }
 
 void Possibilities_Board::unplace_all_ships() { board = refrence_board;}
 
+void Possibilities_Board::make_shot(Point p, char result, int sunkShipId) {
+    /*
+     puts the shot on the refrence board the same way update (and ship_destroyed, for a sink) would,
+     then drops every location it rules out.
+     A shot only ever rules locations out, so rather than rebuilding the lists,
+     the ones still possible are swapped to the front of each list and n_locations shrinks;
+     the others stay behind it, and unmake_shot just grows n_locations back over them.
+     The order within a list changes, which doesn't matter since place_ships picks from it at random
+     */
+    size_t cell = m_game.cols() * p.r + p.c;
+    int sunk = (result == 'X' && sunkShipId >= 0 && sunkShipId < m_fleet.nShips) ? sunkShipId : -1;
+    Undo u = {cell, sunk, misses[cell], refrence_board.hits[cell], refrence_board.taken[cell],
+              sunk >= 0 && refrence_board.ships[sunk][cell]};
+    undo_stack.push_back(u);
+    sizes_stack.insert(sizes_stack.end(), n_locations.begin(), n_locations.end());
+    if (sunk >= 0) { assignments_stack.push_back(assignments);}
+
+    if (result == 'o')  { misses.set(cell);}
+    else if (sunk < 0)  { refrence_board.hits.set(cell);}
+    else {
+        destroyed_ships.push_back(sunk);
+        destroyed[sunk] = 1;
+        refrence_board.hits.reset(cell);
+        refrence_board.taken.set(cell);
+        refrence_board.ships[sunk].set(cell);
+    }
+    board = refrence_board;
+
+    // a plain hit rules nothing out, and otherwise only locations over the shot cell can have gone bad,
+    // except for the ship just sunk, which now has to lie on hits alone
+    if (result != 'o' && sunk < 0) {return;}
+    for (size_t s = 0, N = m_fleet.nShips; s < N; ++s) {
+        vector<Possible_Location>& list = locations_list[s];
+        bool all = static_cast<int>(s) == sunk;
+        size_t kept = 0;
+        for (size_t k = 0; k < n_locations[s]; ++k) {
+            if ((!all && !list[k].placement->mask[cell]) || is_valid(list[k])) { swap(list[kept++], list[k]);}
+        }
+        n_locations[s] = kept;
+    }
+    if (sunk >= 0) { update_sunk_assignments();}
+    order_ships();
+}
+
+bool Possibilities_Board::unmake_shot() {
+    if (undo_stack.empty()) {return false;}
+    const Undo& u = undo_stack.back();
+    misses[u.cell] = u.was_miss;
+    refrence_board.hits[u.cell] = u.was_hit;
+    refrence_board.taken[u.cell] = u.was_taken;
+    if (u.sunk >= 0) {
+        refrence_board.ships[u.sunk][u.cell] = u.was_own;
+        destroyed_ships.pop_back();
+        destroyed[u.sunk] = 0;
+        assignments = assignments_stack.back();
+        assignments_stack.pop_back();
+    }
+    board = refrence_board;
+
+    size_t n_ships = n_locations.size();
+    copy(sizes_stack.end() - n_ships, sizes_stack.end(), n_locations.begin());
+    sizes_stack.resize(sizes_stack.size() - n_ships);
+    undo_stack.pop_back();
+    order_ships();
+    return true;
+}
+
 
 //*********************************************************************
 //  Possibilities Board Private Functions
@@ -114,162 +410,174 @@ bool Possibilities_Board::is_valid(Possible_Location L) const{
      if not sunk, ensures the ship only crosses '.', 'X', or its own symbol
      if sunk, ensures the ship only crosses 'X' or its own symbol
      and ensures the ship did indeed cross its own symbol
+     The placement is already known to be on the board, so each of these is one test on its mask
      */
-    if (L.shipId >= m_game.nShips()) { return false;} // invalid shipId
-    
-    size_t start = m_game.cols() * L.topOrLeft.r + L.topOrLeft.c;
+    if (L.shipId >= m_fleet.nShips) { return false;} // invalid shipId
     
-    bool destroyed = is_ship_destroyed(L.shipId); // determine if the ship has been sunk (extra validity checks)
-    bool occupies_sunk_square = false;
+    const CellSet& cells = L.placement->mask;
+    const CellSet& own = board.ships[L.shipId];
     
-    if (!destroyed) { // checks for ships that haven't been destroyed
-        if (L.dir == HORIZONTAL) {
-            for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-                // we are at the end of a row & have more to go
-                if ( (((start + i + 1) % m_game.cols()) == 0) && (i+1 < N))                           { return false;} // runs off edge
-                if (!(board[start + i] == '.' || board[start + i] == 'X'
-                      || board[start + i] == m_game.shipSymbol(L.shipId)))                            { return false;} // runs over something
-            }
-        }
-        else {
-            for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-                if (start + m_game.cols()*i > board.size())                                           { return false;} // runs of edge
-                if (!(board[start + m_game.cols()*i] == '.' || board[start + m_game.cols()*i] == 'X'
-                      || board[start + m_game.cols()*i] == m_game.shipSymbol(L.shipId)))              { return false;} // runs over something
+    if (!is_ship_destroyed(L.shipId)) { // checks for ships that haven't been destroyed
+        return (cells & (misses | (board.taken & ~own))).none();                           // runs over something
+    }
+    // checks for ships that have been destroyed
+    return (cells & ~(board.hits | own)).none() &&                                          // runs over a non-hit
+           (cells & own).any();                                                             // we never ran over sunk square
+}
+
+CellSet Possibilities_Board::placed_cells() const {
+    // the cells the ships placed this time cover that were unknown ('.') on the refrence board
+    return board.taken & ~refrence_board.taken & ~refrence_board.hits & ~misses;
+}
+
+uint64_t Possibilities_Board::layout_hash() const {
+    // where every ship is this time, hashed, so sample can tell layouts apart
+    hash<CellSet> cells_hash;
+    uint64_t h = 0;
+    for (size_t s = 0, N = board.ships.size(); s < N; ++s) { h = (h ^ cells_hash(board.ships[s])) * 0x9E3779B97F4A7C15ULL;}
+    return h;
+}
+
+void Possibilities_Board::update_sunk_assignments() {
+    /*
+     brings the sunk assignments up to date (see Possibilities.h). First every way so far goes on with each location
+     of each ship sunk since that doesn't overlap it. Then the ways the board now rules out are dropped:
+     those with a location that is no longer valid, and those that leave a hit no afloat ship can cover
+     without running into a sunk one. If there were too many last time, it starts over, in case there are fewer now.
+     Call with board the same as the refrence board
+     */
+    if (destroyed_ships.empty() || assignments.too_many) {
+        assignments.list.clear();
+        assignments.assigned = 0;
+        assignments.too_many = false;
+        if (destroyed_ships.empty()) {return;}
+    }
+    if (assignments.assigned == 0) { assignments.list.assign(1, Sunk_Assignment());}
+    for (; assignments.assigned < destroyed_ships.size(); ++assignments.assigned) {
+        int s = destroyed_ships[assignments.assigned];
+        vector<Sunk_Assignment> extended;
+        for (size_t j = 0, N = assignments.list.size(); j < N; ++j) {
+            for (size_t k = 0; k < n_locations[s]; ++k) {
+                const Possible_Location& L = locations_list[s][k];
+                if ((L.placement->mask & assignments.list[j].cells).any()) {continue;}
+                if (extended.size() == MAX_SUNK_ASSIGNMENTS) {
+                    assignments.list.clear();
+                    assignments.too_many = true;
+                    return;
+                }
+                extended.push_back(assignments.list[j]);
+                extended.back().locations.push_back(L);
+                extended.back().cells |= L.placement->mask;
             }
         }
+        assignments.list.swap(extended);
     }
     
-    else { // checks for ships that have been destroyed
-        if (L.dir == HORIZONTAL) {
-            for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-                // we are at the end of a row & have more to go
-                if ( (((start + i + 1) % m_game.cols()) == 0) && (i+1 < N))                           { return false;} // runs off edge
-                if (board[start + i] != 'X') {                                                                         // runs over a non-hit
-                    if (board[start + i] == m_game.shipSymbol(L.shipId)) {                                             // if own symbol, good
-                        occupies_sunk_square = true;
-                    }
-                    else { return false;}
+    size_t kept = 0;
+    for (size_t j = 0, N = assignments.list.size(); j < N; ++j) {
+        const Sunk_Assignment& a = assignments.list[j];
+        bool possible = true;
+        for (size_t i = 0, M = a.locations.size(); i < M && possible; ++i) { possible = is_valid(a.locations[i]);}
+        CellSet loose = refrence_board.hits & ~a.cells;
+        for (size_t cell = 0, M = m_game.rows() * m_game.cols(); cell < M && possible; ++cell) {
+            if (!loose[cell]) {continue;}
+            bool covered = false;
+            for (int s = 0, S = m_fleet.nShips; s < S && !covered; ++s) {
+                if (destroyed[s]) {continue;}
+                for (size_t k = 0; k < n_locations[s] && !covered; ++k) {
+                    const CellSet& mask = locations_list[s][k].placement->mask;
+                    covered = mask[cell] && (mask & a.cells).none();
                 }
             }
+            possible = covered;
         }
-        else {
-            for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-                if (start + m_game.cols()*i > board.size())                                           { return false;} // runs of edge
-                if (board[start + m_game.cols()*i] != 'X') {                                                           // runs over a non-hit
-                    if (board[start + m_game.cols()*i] == m_game.shipSymbol(L.shipId)) {                               // if own symbol, good
-                        occupies_sunk_square = true;
-                    }
-                    else { return false;}
-                }
-            }
+        if (possible) {
+            if (kept != j) { swap(assignments.list[kept], assignments.list[j]);}
+            ++kept;
         }
-        if (!occupies_sunk_square) { return false;} // we never ran over sunk square
     }
-    return true;
+    assignments.list.resize(kept);
+}
+
+void Possibilities_Board::order_ships() {
+    /*
+     order_ships sets the order place_ships_recursively places the ships in: fewest locations first,
+     so a ship with little room goes on while there's still room for it, and a dead end turns up near the top
+     of the recursion instead of at its leaves. The sunk ships are left out, since place_ships puts them on
+     from the sunk assignments, unless there were too many of those to list; then they go first.
+     Each ship's choices are reset to all of its locations
+     */
+    placement_order.clear();
+    for (int s = 0, N = m_fleet.nShips; s < N; ++s) {
+        if (!destroyed[s] || assignments.too_many) { placement_order.push_back(s);}
+        choices[s].resize(n_locations[s]);
+        for (size_t k = 0; k < n_locations[s]; ++k) { choices[s][k] = static_cast<int>(k);}
+    }
+    sort(placement_order.begin(), placement_order.end(), [this](int a, int b) {
+        if (destroyed[a] != destroyed[b]) {return destroyed[a] > destroyed[b];}
+        if (n_locations[a] != n_locations[b]) {return n_locations[a] < n_locations[b];}
+        return a < b;
+    });
 }
 
 bool Possibilities_Board::place_ship(Possible_Location L) {
     
     if (!is_valid(L)) {return false;}
     
-    size_t start = m_game.cols() * L.topOrLeft.r + L.topOrLeft.c;
-    if (L.dir == HORIZONTAL) {
-        for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-            board[start + i] = m_game.shipSymbol(L.shipId);
-        }
-    }
-    
-    else {
-        for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-            board[start + m_game.cols()*i] = m_game.shipSymbol(L.shipId);
-        }
-    }
+    const CellSet& cells = L.placement->mask;
+    board.hits &= ~cells;
+    board.taken |= cells;
+    board.ships[L.shipId] |= cells;
     return true;
 }
 
 bool Possibilities_Board::unplace_ship(Possible_Location L) {
-    if (L.shipId >= m_game.nShips()) { return false;}
-    size_t start = m_game.cols() * L.topOrLeft.r + L.topOrLeft.c;
+    if (L.shipId >= m_fleet.nShips) { return false;}
     
     // skipping some of the checks done in boards unplace ships,
     // I find them unneccessary with unplace_ship being a private function for this class
-    if (L.dir == HORIZONTAL) {
-        for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-            board[start + i] = refrence_board[start + i];
-        }
-    }
-    
-    else {
-        for(size_t i = 0, N = m_game.shipLength(L.shipId); i < N; ++i) {
-            board[start + m_game.cols()*i] = refrence_board[start + m_game.cols()*i];
-        }
-    }
+    // the ship's cells go back to whatever the refrence board has there
+    const CellSet& cells = L.placement->mask;
+    board.hits  = (board.hits  & ~cells) | (refrence_board.hits  & cells);
+    board.taken = (board.taken & ~cells) | (refrence_board.taken & cells);
+    board.ships[L.shipId] = (board.ships[L.shipId] & ~cells) | (refrence_board.ships[L.shipId] & cells);
     return true;
 }
 
 
-bool Possibilities_Board::place_ships_recursively(int shipId, bool sunks_now, size_t which_sunk) {
+bool Possibilities_Board::place_ships_recursively(size_t depth, mt19937& generator) {
     /*
-     Place ships recursively has two main phases, one where we are placing the ships that have been sunk,
-     and the next where we are just placing ships one by one in order
-     Some control flow is necessary to manage interactions between these two phases
+     Place ships recursively places the ships of placement_order one by one, from depth on
+     (see order_ships; the sunk ships are usually already on the board, from place_ships)
      
      Overall, every placement prompts a recursive call,
      if the call returns false, then a different placement is tried for the current ship
      if there are no more possible placements, then the current function returns false
      if the call had returned true, then the current function returns true.
-     The condition for the first return true would be if we are in phase two (normal, in order recursion)
-     and our shipId is equal to our number of ships
+     The condition for the first return true would be our depth being past the last ship.
+     The locations are tried in a random order without repeats, by shuffling the ship's choices as we go,
+     and once the sample has used up its tries (tries_left, see Possibilities.h) every call returns false
      
-     @param int shipId: the ship being placed
-     @param bool sunks_now: which phase we are in, true being placing sunk ships only, false being normal recursion
-     @param size_t which_sunk: the index of destroyed_ships we are currently on
+     @param size_t depth: how far through placement_order we are
+     @param mt19937& generator: where the shuffles' random numbers come from
      */
     
-    // return condition: not sunks_now and shipId >= our number of ships
-    if (!sunks_now && shipId >= m_game.nShips() )          { return true;}
-    // shift from sunks_now to normal recursion once our index is larger than destroyed ships
-    if (sunks_now && which_sunk >= destroyed_ships.size()) { return place_ships_recursively(0, 0, which_sunk);}
-    // skip a step in normal recursion if the ship is in destroyed ships
-    if (!sunks_now && is_ship_destroyed(shipId))           { return place_ships_recursively(shipId+1, 0, which_sunk);}
+    // return condition: every ship has been placed
+    if (depth >= placement_order.size()) { return true;}
     
-    vector<int> already_guessed = {};
-    size_t number_of_options = locations_list[shipId].size();
-    
-    bool valid_guess;
-    int choice;
-    while (already_guessed.size() < number_of_options) {
-        // the do-while is to ensure that we don't repeat guesses
-        // this could take awhile if there are limited possibilities and we are unlucky
-        // we try to avoid this being catastrophic by placing the sunk ships first
-        do {
-            valid_guess = true;
-            choice = randInt(static_cast<int>(number_of_options));
-            for (size_t i = 0, N = already_guessed.size(); i < N; ++i) {
-                if (choice == already_guessed[i]) {valid_guess = false;}
-            }
-        }
-        while (!valid_guess);
-        
-        already_guessed.push_back(choice);
-        Possible_Location random_location = locations_list[shipId][choice];
+    int shipId = placement_order[depth];
+    vector<int>& options = choices[shipId];
+    for (size_t t = 0, N = options.size(); t < N; ++t) {
+        if (--tries_left < 0) {return false;}
+        swap(options[t], options[t + randInt(static_cast<int>(N - t), generator)]);
+        const Possible_Location& random_location = locations_list[shipId][options[t]];
         
         // if the placement was successful, try to place the next ship
-        // while managing which phase of the recursion we are in
         if (place_ship(random_location)) {
-            if (sunks_now) {
-                if (!place_ships_recursively(destroyed_ships[which_sunk+1], 1, which_sunk+1)) {
-                    unplace_ship(random_location);
-                }
-                else {return true;}
-            }
-            else {
-                if (!place_ships_recursively(shipId + 1, 0, which_sunk)) {
-                    unplace_ship(random_location);
-                }
-                else {return true;}
+            if (!place_ships_recursively(depth + 1, generator)) {
+                unplace_ship(random_location);
             }
+            else {return true;}
         }
     }
     return false; // we've run out of possible locations
@@ -9,6 +9,8 @@
 #define POSSIBILITIES_ORIGINAL
 
 #include "globals.h"
+#include <cstdint>
+#include <vector>
 
 /*
  Possibilities_Board and its nested class Possible_Locations are designed to assist GoodPlayer::recomend_attack
@@ -23,11 +25,31 @@
  read that board placement to an outside vector,
  and clear the board to allow the process to occur again
  all as efficiently as possible.
+ 
+ make_shot and unmake_shot let a player look ahead: make_shot puts a hypothetical result on the board
+ ('o' for a miss, 'X' for a hit, or 'X' with the id of the ship it sinks) and unmake_shot takes the latest one back,
+ so a search can try thousands of shot sequences without copying the board.
+ They work on the lists determine_locations made, so call that first, and don't call it (or update) again
+ while any hypothetical shot is still on the board
  Specific details are present in the individual functions' documentation
  */
 
 class Point;
 class Player;
+struct ShipPlacement;
+struct Fleet;
+
+/*
+ What a call to Possibilities_Board::sample found. Late in a game there may be only a handful of layouts left,
+ and then most samples are repeats that add nothing, so sample first looks for repeats (see sample):
+ once it has seen every layout there is, it stops and counts each of them once
+ */
+struct Sample_Report
+{
+    size_t accepted;        // samples that fit
+    size_t distinct;        // different layouts among them, as far as it looked (up to EXHAUST_LAYOUTS + 1)
+    bool exhausted;         // every layout was found, and counts came from them exactly
+};
 
 class Possibilities_Board
 {
@@ -38,28 +60,105 @@ class Possibilities_Board
     void ship_destroyed(int shipId);
     bool is_ship_destroyed(int shipId) const;
     void read_to(std::vector<int>& data) const;
+    const CellSet& ship_cells(int shipId) const { return board.ships[shipId];}
     void determine_locations();
+    CellSet certain_cells() const;
+    void read_density(std::vector<double>& density, double hitWeight = 5) const;   // 5 fit the exact answers best (see Accuracy.h)
+    bool sample(std::vector<int>& counts, size_t samples, double limitMillis, Sample_Report* report = nullptr) const;
+    static const size_t EXHAUST_LAYOUTS = 512;     // with more different layouts than this, sample stops looking for repeats
     bool is_valid_board() const;
     bool place_ships();
+    bool place_ships(std::mt19937& generator);
     void unplace_all_ships();
+    void make_shot(Point p, char result, int sunkShipId = -1);
+    bool unmake_shot();
+    size_t shots_made() const { return undo_stack.size();}
   private:
-    bool place_ships_recursively(int shipId, bool sunks, size_t which_sunk ); 
+    /*
+     The board is kept as cell masks rather than characters, so checking a placement against it
+     is a handful of operations on the placement's mask, the same for a ship of any shape or size.
+     In the old character terms: a cell in misses is 'o', a cell in hits is 'X',
+     a cell in ships[s] carries ship s's symbol, and any other cell is '.'
+     */
+    struct Layer
+    {
+        CellSet hits;                   // hits not (yet) covered by a ship
+        CellSet taken;                  // the union of ships
+        std::vector<CellSet> ships;     // cells carrying each ship's symbol
+    };
+    bool place_ships_recursively(size_t depth, std::mt19937& generator);
+    void update_sunk_assignments();
+    void order_ships();
     bool place_ship(Possible_Location L);
     bool unplace_ship(Possible_Location L);
     bool is_valid(Possible_Location L) const;
+    CellSet placed_cells() const;
+    uint64_t layout_hash() const;
+    bool hits_alone() const;
     const Game& m_game;
-    std::vector<char> board;
-    std::vector<char> refrence_board;
+    const Fleet& m_fleet;               // the ships, looked up without going through the game (see Game.h)
+    CellSet misses;                     // the same for the board and the refrence board
+    Layer board;
+    Layer refrence_board;
     std::vector<int> destroyed_ships;
+    std::vector<char> destroyed;        // destroyed[s]: whether s is in destroyed_ships, without looking through it
     std::vector<std::vector<Possible_Location>> locations_list;
+    std::vector<size_t> n_locations;    // locations_list[s] is only good up to n_locations[s], see make_shot
+    
+    /*
+     How place_ships_recursively goes through the ships (see order_ships): placement_order is the ships it places,
+     in order, and choices[s] holds the indices of ship s's locations, shuffled as they're tried.
+     Each sample may try at most TRIES_PER_SHIP locations per ship in all, so a crowded board
+     can't send one sample down an endless search
+     */
+    static const long TRIES_PER_SHIP = 50;
+    std::vector<int> placement_order;
+    std::vector<std::vector<int>> choices;
+    long tries_left;
+    
+    /*
+     What make_shot changed, so unmake_shot can put it back:
+     the shot cell's bits before the shot, and each ship's n_locations (kept in sizes_stack, one per ship per shot)
+     */
+    struct Undo
+    {
+        size_t cell;
+        int sunk;
+        bool was_miss, was_hit, was_taken, was_own;
+    };
+    std::vector<Undo> undo_stack;
+    std::vector<size_t> sizes_stack;
+    
+    /*
+     Which hits the sunk ships are on: every way of placing all of them at once (one location each, none overlapping)
+     that leaves each other hit somewhere an afloat ship could still cover. They're worked out in determine_locations,
+     going on from the last list with just the ships sunk since, and the list is pruned there as shots rule ways out,
+     so place_ships picks the sunk ships from it rather than searching for them every sample.
+     A sinking make_shot extends the list too, keeping the old one in assignments_stack for unmake_shot.
+     With many small sunk ships the ways can multiply past any use, and then the sunk ships are just searched for
+     along with the ships afloat
+     */
+    struct Sunk_Assignment
+    {
+        std::vector<Possible_Location> locations;   // in the order of destroyed_ships
+        CellSet cells;                              // all of their cells
+    };
+    static const size_t MAX_SUNK_ASSIGNMENTS = 4096;  // past this many, the sunk ships are searched for like the others
+    struct Sunk_Assignments
+    {
+        std::vector<Sunk_Assignment> list;
+        size_t assigned;                            // how many of destroyed_ships the assignments place
+        bool too_many;                              // there were more than MAX_SUNK_ASSIGNMENTS, so the list is empty
+    };
+    Sunk_Assignments assignments;
+    std::vector<Sunk_Assignments> assignments_stack;
 };
 
 struct Possibilities_Board::Possible_Location
 {
-    Possible_Location(Point _topOrLeft, int _shipId, Direction _dir);
-    Point topOrLeft;
+    Possible_Location(int _shipId, const ShipPlacement* _placement);
     int shipId;
-    Direction dir;
+    const ShipPlacement* placement;     // one of the ship's precomputed placements (see ShipShape.h)
 };
 
 
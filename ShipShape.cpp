@@ -0,0 +1,147 @@
+//
+//  ShipShape.cpp
+//  Battleship
+//
+
+#include "ShipShape.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// shifts the cells so the top row and left column are 0, and sorts them so equal shapes compare equal
+static vector<Point> normalized(vector<Point> cells) {
+    int min_r = cells[0].r, min_c = cells[0].c;
+    for (size_t i = 0, N = cells.size(); i < N; ++i) {
+        min_r = min(min_r, cells[i].r);
+        min_c = min(min_c, cells[i].c);
+    }
+    for (size_t i = 0, N = cells.size(); i < N; ++i) {
+        cells[i].r -= min_r;
+        cells[i].c -= min_c;
+    }
+    sort(cells.begin(), cells.end(), [](Point a, Point b) { return a.r != b.r ? a.r < b.r : a.c < b.c;});
+    return cells;
+}
+
+static bool same_cells(const vector<Point>& a, const vector<Point>& b) {
+    for (size_t i = 0, N = a.size(); i < N; ++i) {
+        if (a[i].r != b[i].r || a[i].c != b[i].c) {return false;}
+    }
+    return true;
+}
+
+// a quarter turn clockwise, and the mirror image left to right
+static vector<Point> rotated(const vector<Point>& cells) {
+    vector<Point> result;
+    for (size_t i = 0, N = cells.size(); i < N; ++i) { result.push_back(Point(cells[i].c, -cells[i].r));}
+    return normalized(result);
+}
+
+static vector<Point> reflected(const vector<Point>& cells) {
+    vector<Point> result;
+    for (size_t i = 0, N = cells.size(); i < N; ++i) { result.push_back(Point(cells[i].r, -cells[i].c));}
+    return normalized(result);
+}
+
+
+ShipShape::ShipShape(const vector<Point>& cells, int nRows, int nCols) : rows(nRows), cols(nCols), m_straight(false) {
+    vector<Point> shape = normalized(cells);
+    bool one_row = true, one_col = true;
+    for (size_t i = 0, N = shape.size(); i < N; ++i) {
+        if (shape[i].r != 0) {one_row = false;}
+        if (shape[i].c != 0) {one_col = false;}
+    }
+    m_straight = one_row || one_col;
+    if (one_col && !one_row) {shape = rotated(shape);}   // straight ships start out along a row
+
+    /*
+     the four rotations, then the four rotations of the mirror image,
+     keeping only the first of any that cover the same cells.
+     same_as[o] is the orientation whose placements orientation o shares,
+     which is only ever a different one for the second orientation of a one cell ship
+     */
+    vector<int> same_as;
+    for (int k = 0; k < 8; ++k) {
+        if (k == 4) {shape = reflected(shape);}
+        bool seen = false;
+        for (size_t o = 0, N = m_orientations.size(); o < N && !seen; ++o) { seen = same_cells(m_orientations[o], shape);}
+        if (!seen) {
+            m_orientations.push_back(shape);
+            same_as.push_back(static_cast<int>(same_as.size()));
+        }
+        shape = rotated(shape);
+    }
+    if (m_straight && m_orientations.size() == 1) {
+        m_orientations.push_back(m_orientations[0]);
+        same_as.push_back(0);
+    }
+
+    // every placement of every orientation that fits on the board
+    placement_at.assign(m_orientations.size() * rows * cols, -1);
+    for (size_t o = 0, N = m_orientations.size(); o < N; ++o) {
+        if (same_as[o] != static_cast<int>(o)) {
+            copy(placement_at.begin() + same_as[o]*rows*cols, placement_at.begin() + (same_as[o] + 1)*rows*cols,
+                 placement_at.begin() + o*rows*cols);
+            continue;
+        }
+        const vector<Point>& shape_cells = m_orientations[o];
+        int height = 0, width = 0;
+        for (size_t i = 0, M = shape_cells.size(); i < M; ++i) {
+            height = max(height, shape_cells[i].r + 1);
+            width  = max(width,  shape_cells[i].c + 1);
+        }
+        for (int r = 0; r + height <= rows; ++r) {
+            for (int c = 0; c + width <= cols; ++c) {
+                ShipPlacement L;
+                L.topOrLeft = Point(r, c);
+                L.orientation = static_cast<int>(o);
+                for (size_t i = 0, M = shape_cells.size(); i < M; ++i) {
+                    int cell = (r + shape_cells[i].r) * cols + c + shape_cells[i].c;
+                    L.cells.push_back(cell);
+                    L.mask.set(cell);
+                }
+                placement_at[o*rows*cols + r*cols + c] = static_cast<int>(m_placements.size());
+                m_placements.push_back(L);
+            }
+        }
+    }
+}
+
+vector<Point> ShipShape::straight(int length) {
+    vector<Point> cells;
+    for (int i = 0; i < length; ++i) { cells.push_back(Point(0, i));}
+    return cells;
+}
+
+bool ShipShape::is_polyomino(const vector<Point>& cells) {
+    // at least one cell, no cell twice, and every cell reachable from the first through side by side neighbors
+    if (cells.empty() || cells.size() > static_cast<size_t>(MAXCELLS)) {return false;}
+    for (size_t i = 0, N = cells.size(); i < N; ++i) {
+        for (size_t j = i + 1; j < N; ++j) {
+            if (cells[i].r == cells[j].r && cells[i].c == cells[j].c) {return false;}
+        }
+    }
+    vector<bool> reached(cells.size(), false);
+    vector<size_t> frontier(1, 0);
+    reached[0] = true;
+    size_t n_reached = 1;
+    while (!frontier.empty()) {
+        Point p = cells[frontier.back()];
+        frontier.pop_back();
+        for (size_t j = 0, N = cells.size(); j < N; ++j) {
+            if (reached[j] || abs(cells[j].r - p.r) + abs(cells[j].c - p.c) != 1) {continue;}
+            reached[j] = true;
+            ++n_reached;
+            frontier.push_back(j);
+        }
+    }
+    return n_reached == cells.size();
+}
+
+const ShipPlacement* ShipShape::find(Point topOrLeft, int orientation) const {
+    if (orientation < 0 || orientation >= orientations()) {return nullptr;}
+    if (topOrLeft.r < 0 || topOrLeft.r >= rows || topOrLeft.c < 0 || topOrLeft.c >= cols) {return nullptr;}
+    int k = placement_at[orientation*rows*cols + topOrLeft.r*cols + topOrLeft.c];
+    return k < 0 ? nullptr : &m_placements[k];
+}
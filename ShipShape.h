@@ -0,0 +1,57 @@
+//
+//  ShipShape.h
+//  Battleship
+//
+
+#ifndef SHIPSHAPE_INCLUDED
+#define SHIPSHAPE_INCLUDED
+
+#include "globals.h"
+#include <vector>
+
+/*
+ A ShipShape is any polyomino: a set of cells, each joined to another along a side.
+ A straight ship of length n is just the shape with n cells in a row.
+
+ When a ship is added to a Game, its shape works out every distinct way it can be turned over or rotated
+ (its orientations, up to 8), and then every way each orientation fits on that game's board (its placements).
+ Each placement carries its cells both as a list and as a CellSet mask,
+ so placing, checking and sampling a ship costs the same whatever its shape.
+
+ Orientations are numbered from 0. Every placement is named by its orientation
+ and the top left corner of the orientation's bounding box (topOrLeft, as it always was for straight ships).
+ Straight ships always have orientation 0 running along a row and orientation 1 down a column,
+ which is all HORIZONTAL and VERTICAL are (for a one cell ship the two are the same placements).
+ */
+
+struct ShipPlacement
+{
+    Point topOrLeft;
+    int orientation;
+    CellSet mask;               // the cells the ship covers
+    std::vector<int> cells;     // the same cells, as r*cols + c
+};
+
+class ShipShape
+{
+  public:
+    ShipShape(const std::vector<Point>& cells, int nRows, int nCols);
+    static std::vector<Point> straight(int length);
+    static bool is_polyomino(const std::vector<Point>& cells);
+    int size() const { return static_cast<int>(m_orientations[0].size());}
+    bool is_straight() const { return m_straight;}
+    int orientations() const { return static_cast<int>(m_orientations.size());}
+    const std::vector<Point>& cells(int orientation) const { return m_orientations[orientation];}
+    int placements() const { return static_cast<int>(m_placements.size());}
+    const ShipPlacement& placement(int k) const { return m_placements[k];}
+    const ShipPlacement* find(Point topOrLeft, int orientation) const;  // nullptr if it doesn't fit there
+  private:
+    int rows;
+    int cols;
+    bool m_straight;
+    std::vector<std::vector<Point>> m_orientations;
+    std::vector<ShipPlacement> m_placements;
+    std::vector<int> placement_at;    // [orientation*rows*cols + r*cols + c] -> index into m_placements, or -1
+};
+
+#endif // SHIPSHAPE_INCLUDED
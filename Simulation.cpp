@@ -0,0 +1,206 @@
+//
+//  Simulation.cpp
+//  Battleship
+//
+
+#include "Simulation.h"
+#include "Game.h"
+#include "ShipShape.h"
+
+using namespace std;
+
+//*********************************************************************
+//  SimulationFleet
+//*********************************************************************
+
+SimulationFleet::SimulationFleet() : rows(0), cols(0), n_ships(0) {}
+
+bool SimulationFleet::configure(const Game& g) {
+    if (g.nShips() > MAX_SIM_SHIPS) {return false;}
+    for (int s = 0; s < g.nShips(); ++s) {
+        if (!g.shipShape(s).is_straight()) {return false;}
+    }
+    rows = g.rows();
+    cols = g.cols();
+    n_ships = g.nShips();
+    for (int s = 0; s < n_ships; ++s) { lengths[s] = static_cast<unsigned char>(g.shipLength(s));}
+    cells.reset();
+    odd_cells.reset();
+    for (int i = 0; i < rows*cols; ++i) {
+        cells.set(i);
+        if ((i / cols + i % cols) % 2 == 1) {odd_cells.set(i);}
+    }
+    return true;
+}
+
+
+//*********************************************************************
+//  CompactGame
+//*********************************************************************
+
+uint32_t CompactGame::next_random() {
+    // xorshift64*, 8 bytes of state rather than the 5000 of an mt19937
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return static_cast<uint32_t>((rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void CompactGame::start(const SimulationFleet& f, SimStrategy first, SimStrategy second, uint64_t seed) {
+    rng = seed * 0x9E3779B97F4A7C15ULL + 1; // never zero, which xorshift can't leave
+    strategy[0] = static_cast<unsigned char>(first);
+    strategy[1] = static_cast<unsigned char>(second);
+    for (int side = 0; side < 2; ++side) {
+        shots[side].reset();
+        resolved[side].reset();
+        turns_taken[side] = 0;
+        ships_left[side] = static_cast<unsigned char>(f.n_ships);
+        while (!place_fleet(f, side)) {}
+    }
+    to_move = 0;
+    winning_side = -1;
+}
+
+bool CompactGame::place_fleet(const SimulationFleet& f, int side) {
+    // uniformly random layout: draw every ship, and throw the whole layout out if any of them doesn't fit
+    ships[side].reset();
+    for (int s = 0; s < f.n_ships; ++s) {
+        int r = next_random() % f.rows;
+        int c = next_random() % f.cols;
+        bool vertical = next_random() % 2;
+        for (int i = 0; i < f.lengths[s]; ++i) {
+            int rr = r + (vertical ? i : 0);
+            int cc = c + (vertical ? 0 : i);
+            if (rr >= f.rows || cc >= f.cols || ships[side][rr*f.cols + cc]) {return false;}
+            ships[side].set(rr*f.cols + cc);
+            owner[side][rr*f.cols + cc] = static_cast<unsigned char>(s);
+        }
+        remaining[side][s] = f.lengths[s];
+    }
+    return true;
+}
+
+int CompactGame::random_cell(const CellSet& cells) {
+    // the k-th set cell, for a random k
+    size_t n = cells.count();
+    if (n == 0) {return -1;}
+    size_t k = next_random() % n;
+    for (int i = 0; i < MAXCELLS; ++i) {
+        if (cells[i] && k-- == 0) {return i;}
+    }
+    return -1;
+}
+
+int CompactGame::hunt_target(const SimulationFleet& f, int side) {
+    /*
+     the target board is the other side's, and everything used here is something the attacker has seen:
+     its shots, which of them hit, and which hits it has already put down to sunk ships.
+     For each unexplained hit, first try to continue a line of hits through it, then try its neighbors.
+     With no unexplained hits, shoot a random untried cell of odd parity (any untried cell once those run out)
+     */
+    int board = 1 - side;
+    CellSet hits = shots[board] & ships[board];
+    CellSet unexplained = hits & ~resolved[side];
+    const int dr[4] = {-1, 0, 1, 0};
+    const int dc[4] = {0, 1, 0, -1};
+    for (int cell = 0, N = unexplained.any() ? f.rows*f.cols : 0; cell < N; ++cell) {
+        if (!unexplained[cell]) {continue;}
+        int r = cell / f.cols, c = cell % f.cols;
+        for (int pass = 0; pass < 2; ++pass) {                  // pass 0: lines of hits, pass 1: any neighbor
+            for (int d = 0; d < 4; ++d) {
+                int rr = r + dr[d], cc = c + dc[d];
+                if (pass == 0) {
+                    int br = r - dr[d], bc = c - dc[d];         // the line needs a hit behind us
+                    if (br < 0 || br >= f.rows || bc < 0 || bc >= f.cols || !unexplained[br*f.cols + bc]) {continue;}
+                }
+                if (rr < 0 || rr >= f.rows || cc < 0 || cc >= f.cols) {continue;}
+                if (!shots[board][rr*f.cols + cc]) {return rr*f.cols + cc;}
+            }
+        }
+    }
+    CellSet untried = f.cells & ~shots[board];
+    CellSet parity = untried & f.odd_cells;
+    return parity.any() ? random_cell(parity) : random_cell(untried);
+}
+
+int CompactGame::choose_target(const SimulationFleet& f, int side) {
+    if (strategy[side] == SIM_SWEEP) {
+        return f.rows*f.cols - 1 - turns_taken[side];   // never repeats, so always legal
+    }
+    return hunt_target(f, side);
+}
+
+void CompactGame::resolve_sink(const SimulationFleet& f, int side, int cell, int length) {
+    /*
+     the attacker only learns which ship sank and where the last shot landed,
+     so it looks for a straight run of `length` unexplained hits through that cell
+     and puts them all down to the sunk ship (just the sinking cell if no run fits)
+     */
+    int board = 1 - side;
+    CellSet unexplained = shots[board] & ships[board] & ~resolved[side];
+    int r = cell / f.cols, c = cell % f.cols;
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int offset = 0; offset < length; ++offset) {
+            int r0 = r - (vertical ? offset : 0);
+            int c0 = c - (vertical ? 0 : offset);
+            bool fits = r0 >= 0 && c0 >= 0;
+            for (int i = 0; fits && i < length; ++i) {
+                int rr = r0 + (vertical ? i : 0), cc = c0 + (vertical ? 0 : i);
+                fits = rr < f.rows && cc < f.cols && unexplained[rr*f.cols + cc];
+            }
+            if (!fits) {continue;}
+            for (int i = 0; i < length; ++i) {
+                resolved[side].set((r0 + (vertical ? i : 0))*f.cols + c0 + (vertical ? 0 : i));
+            }
+            return;
+        }
+    }
+    resolved[side].set(cell);
+}
+
+bool CompactGame::step(const SimulationFleet& f) {
+    // one attack by the side to move, returns false once the game is over
+    if (finished()) {return false;}
+    int side = to_move;
+    int board = 1 - side;
+    int cell = choose_target(f, side);
+    shots[board].set(cell);
+    ++turns_taken[side];
+    if (ships[board][cell]) {
+        int id = owner[board][cell];
+        if (--remaining[board][id] == 0) {
+            resolve_sink(f, side, cell, f.lengths[id]);
+            if (--ships_left[board] == 0) {
+                winning_side = static_cast<signed char>(side);
+                return false;
+            }
+        }
+    }
+    to_move = static_cast<unsigned char>(board);
+    return true;
+}
+
+
+//*********************************************************************
+//  simulate_games
+//*********************************************************************
+
+long simulate_games(const SimulationFleet& f, SimStrategy first, SimStrategy second,
+                    CompactGame* games, size_t n, uint64_t seed) {
+    for (size_t i = 0; i < n; ++i) { games[i].start(f, first, second, seed + i);}
+
+    // every pass steps each game still in progress once, until none are left
+    size_t in_progress = n;
+    while (in_progress > 0) {
+        in_progress = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (games[i].step(f)) {++in_progress;}
+        }
+    }
+
+    long first_wins = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (games[i].winner() == 0) {++first_wins;}
+    }
+    return first_wins;
+}
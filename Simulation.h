@@ -0,0 +1,82 @@
+//
+//  Simulation.h
+//  Battleship
+//
+
+#ifndef SIMULATION_INCLUDED
+#define SIMULATION_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <cstddef>
+
+/*
+ Headless simulation of the simpler strategies, for when we want a very large number of games.
+
+ A game played through Game::play carries two Boards, two Players (each with its own name string,
+ vectors, and for GoodPlayer a whole Possibilities_Board), and allocates all of them on the heap.
+ CompactGame holds everything one game needs in a single fixed size object of a few hundred bytes:
+ the ships and shots of both sides as bit sets, which ship sits on each cell,
+ what each attacker has worked out about the ships it sank, and a small random generator of its own.
+ A vector of them can hold millions of games in flight, and starting or stepping one never allocates.
+
+ The strategies are simplified versions of the real players:
+     SIM_SWEEP  attacks every cell in order, like AwfulPlayer
+     SIM_HUNT   hunts with parity and targets around unexplained hits, like MediocrePlayer
+ Ship placement is uniformly random, like the layouts in a LayoutCorpus.
+ */
+
+class Game;
+
+const int MAX_SIM_SHIPS = 16;
+
+enum SimStrategy {
+    SIM_SWEEP, SIM_HUNT
+};
+
+struct SimulationFleet
+{
+    SimulationFleet();
+    bool configure(const Game& g); // false if the fleet is too large, or has ships that aren't straight
+    int rows;
+    int cols;
+    int n_ships;
+    unsigned char lengths[MAX_SIM_SHIPS];
+    CellSet cells;        // every cell on the board
+    CellSet odd_cells;    // cells with (r + c) odd
+};
+
+class CompactGame
+{
+  public:
+    void start(const SimulationFleet& f, SimStrategy first, SimStrategy second, uint64_t seed);
+    bool step(const SimulationFleet& f);
+    bool finished() const { return winning_side >= 0;}
+    int winner() const { return winning_side;}
+    int turns(int side) const { return turns_taken[side];}
+  private:
+    bool place_fleet(const SimulationFleet& f, int side);
+    int choose_target(const SimulationFleet& f, int side);
+    int hunt_target(const SimulationFleet& f, int side);
+    int random_cell(const CellSet& cells);
+    void resolve_sink(const SimulationFleet& f, int side, int cell, int length);
+    uint32_t next_random();
+    CellSet ships[2];                           // cells holding a ship, per side
+    CellSet shots[2];                           // cells of each side's board that have been attacked
+    CellSet resolved[2];                        // hits the attacker of each board has put down to sunk ships
+    unsigned char owner[2][MAXCELLS];           // shipId on each cell of each side's board
+    unsigned char remaining[2][MAX_SIM_SHIPS];  // undamaged segments of each ship
+    unsigned char ships_left[2];
+    unsigned char strategy[2];
+    unsigned short turns_taken[2];
+    unsigned char to_move;
+    signed char winning_side;
+    uint64_t rng;
+};
+
+// plays every game in the array to the end, stepping all of them a turn at a time,
+// and returns the number of wins for the first side
+long simulate_games(const SimulationFleet& f, SimStrategy first, SimStrategy second,
+                    CompactGame* games, size_t n, uint64_t seed);
+
+#endif // SIMULATION_INCLUDED
@@ -0,0 +1,157 @@
+//
+//  ThreadPool.cpp
+//  Battleship
+//
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+// index of the worker running on this thread, -1 for threads outside the pool
+static thread_local int current_worker = -1;
+
+// how many tasks this thread is in the middle of running (tasks run other tasks while they wait)
+static thread_local int task_depth = 0;
+
+ThreadPool& ThreadPool::instance() {
+    // the calling thread helps out in TaskGroup::wait(), so one core is left for it
+    static ThreadPool pool(max(1, static_cast<int>(thread::hardware_concurrency())) - 1);
+    return pool;
+}
+
+ThreadPool::ThreadPool(int nWorkers) : n_workers(0), pending(0), stopping(false) { start(nWorkers);}
+
+ThreadPool::~ThreadPool() { stop();}
+
+void ThreadPool::start(int nWorkers) {
+    n_workers = nWorkers;
+    stopping = false;
+    queues.clear();
+    for (int i = 0; i < nWorkers + 2; ++i) { queues.push_back(unique_ptr<Queue>(new Queue));}
+    for (int i = 0; i < nWorkers; ++i) { threads.push_back(thread(&ThreadPool::work, this, i));}
+    stats_start = chrono::steady_clock::now();
+}
+
+void ThreadPool::stop() {
+    stopping = true;
+    wake.notify_all();
+    for (size_t i = 0, N = threads.size(); i < N; ++i) { threads[i].join();}
+    threads.clear();
+}
+
+void ThreadPool::set_workers(int nWorkers) {
+    // every queue is empty when nothing is running, so the old ones can simply go
+    if (nWorkers == n_workers) {return;}
+    stop();
+    start(max(0, nWorkers));
+}
+
+int ThreadPool::own_queue() const { return current_worker >= 0 ? current_worker : workers();}
+
+void ThreadPool::submit(Task task) {
+    // tasks submitted from inside a task go on the thread's own deque, top level ones on the injection queue
+    int target = (current_worker < 0 && task_depth == 0) ? workers() + 1 : own_queue();
+    {
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(task);
+    }
+    ++pending;
+    wake.notify_one();
+}
+
+bool ThreadPool::take(int from, bool newest, Task& task) {
+    lock_guard<mutex> guard(queues[from]->lock);
+    deque<Task>& tasks = queues[from]->tasks;
+    if (tasks.empty()) {return false;}
+    if (newest) { task = tasks.back();  tasks.pop_back();}
+    else        { task = tasks.front(); tasks.pop_front();}
+    --pending;
+    return true;
+}
+
+void ThreadPool::execute(Task& task, int queue, bool stolen) {
+    auto start = chrono::steady_clock::now();
+    ++task_depth;
+    task.work();
+    --task_depth;
+    auto nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    Queue& stats = *queues[queue];
+    if (task_depth == 0) { stats.busy_nanoseconds += nanoseconds;}   // nested tasks are already inside this time
+    ++stats.tasks_run;
+    if (stolen) {++stats.steals;}
+    if (--task.group->remaining == 0) { wake.notify_all();}    // a thread may be asleep in the group's wait()
+}
+
+bool ThreadPool::run_one() {
+    /*
+     runs one task if there is one to be found: the newest from our own deque,
+     otherwise the oldest from another deque (a steal), starting with the next one along,
+     otherwise, if we aren't inside a task already, the oldest from the injection queue
+     */
+    int me = own_queue();
+    int n = workers() + 1;  // the deques, not counting the injection queue
+    Task task;
+    if (take(me, true, task)) { execute(task, me, false); return true;}
+    for (int k = 1; k < n; ++k) {
+        int victim = (me + k) % n;
+        if (take(victim, false, task)) { execute(task, me, true); return true;}
+    }
+    if (task_depth == 0 && take(n, false, task)) { execute(task, me, false); return true;}
+    return false;
+}
+
+void ThreadPool::work(int me) {
+    current_worker = me;
+    while (!stopping) {
+        if (run_one()) {continue;}
+        unique_lock<mutex> guard(sleep_lock);
+        wake.wait_for(guard, chrono::milliseconds(1), [this] { return pending > 0 || stopping;});
+    }
+}
+
+SchedulerStats ThreadPool::stats() const {
+    SchedulerStats result = { workers(), 0, 0, 0 };
+    long long busy = 0;
+    for (int i = 0; i < workers(); ++i) { busy += queues[i]->busy_nanoseconds;}
+    for (size_t i = 0, N = queues.size(); i < N; ++i) {
+        result.tasks_run += queues[i]->tasks_run;
+        result.steals += queues[i]->steals;
+    }
+    double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - stats_start).count();
+    if (workers() > 0 && elapsed > 0) { result.utilization = busy / (elapsed * workers());}
+    return result;
+}
+
+void ThreadPool::reset_stats() {
+    for (size_t i = 0, N = queues.size(); i < N; ++i) {
+        queues[i]->tasks_run = 0;
+        queues[i]->steals = 0;
+        queues[i]->busy_nanoseconds = 0;
+    }
+    stats_start = chrono::steady_clock::now();
+}
+
+
+//*********************************************************************
+//  TaskGroup
+//*********************************************************************
+
+void TaskGroup::run(function<void()> work) {
+    ++remaining;
+    ThreadPool::Task task = { work, this };
+    ThreadPool::instance().submit(task);
+}
+
+void TaskGroup::wait() {
+    /*
+     helps out until every task of this group has finished. When there is nothing left to run,
+     the rest of the group is running on other threads, so we sleep on the pool's condition variable
+     until a task is submitted or one of ours finishes (the timeout covers a wake-up we miss)
+     */
+    ThreadPool& pool = ThreadPool::instance();
+    while (remaining > 0) {
+        if (pool.run_one()) {continue;}
+        unique_lock<mutex> guard(pool.sleep_lock);
+        pool.wake.wait_for(guard, chrono::milliseconds(1), [this, &pool] { return pool.pending > 0 || remaining == 0;});
+    }
+}
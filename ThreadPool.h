@@ -0,0 +1,112 @@
+//
+//  ThreadPool.h
+//  Battleship
+//
+
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+/*
+ One work-stealing thread pool for the whole process, shared by everything that wants to run in parallel.
+ Tournament submits whole games to it, and GoodPlayer submits chunks of its sampling loop to it,
+ so running many GoodPlayer games at once doesn't start threads on top of threads.
+
+ Every worker has its own deque of tasks. A worker takes the newest task from its own deque,
+ and when that is empty it steals the oldest task from another worker's deque.
+ Threads outside the pool (the main thread) share one more deque for the tasks they submit from inside a task,
+ and their top level tasks (whole games) go into a shared injection queue.
+
+ Tasks are run as part of a TaskGroup, and TaskGroup::wait() doesn't just block:
+ the waiting thread runs tasks itself until its group is done. A thread waiting inside a task (say a GoodPlayer move)
+ only runs tasks from the deques (other sampling chunks), never a whole new game from the injection queue,
+ so a long game can't get stuck behind another one. Idle workers steal sampling chunks from busy ones,
+ which is what keeps the cores busy when GoodPlayer's seconds-long moves sit next to MediocrePlayer's tiny ones.
+
+ On a machine with one core there are no worker threads at all, and every task runs inside wait().
+ set_workers() restarts the pool with another number of workers, so the same run can be checked
+ with and without them (the "check" command in main.cpp); only call it from outside the pool, with nothing running.
+ */
+
+class TaskGroup;
+
+struct SchedulerStats
+{
+    int workers;
+    long tasks_run;
+    long steals;
+    double utilization; // fraction of worker time spent running tasks since the stats were reset
+};
+
+class ThreadPool
+{
+    friend class TaskGroup;
+  public:
+    static ThreadPool& instance();
+    int workers() const { return n_workers;}
+    void set_workers(int nWorkers);
+    SchedulerStats stats() const;
+    void reset_stats();
+    ~ThreadPool();
+      // We prevent a ThreadPool object from being copied or assigned
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+  private:
+    struct Task
+    {
+        std::function<void()> work;
+        TaskGroup* group;
+    };
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::atomic<long> tasks_run;
+        std::atomic<long> steals;
+        std::atomic<long long> busy_nanoseconds;
+        Queue() : tasks_run(0), steals(0), busy_nanoseconds(0) {}
+    };
+    explicit ThreadPool(int nWorkers);
+    void start(int nWorkers);
+    void stop();
+    void submit(Task task);
+    bool run_one();
+    int own_queue() const;
+    bool take(int from, bool newest, Task& task);
+    void execute(Task& task, int queue, bool stolen);
+    void work(int me);
+    int n_workers;
+    std::vector<std::unique_ptr<Queue>> queues;   // one per worker, one for outside threads, then the injection queue
+    std::vector<std::thread> threads;
+    std::atomic<int> pending;
+    std::atomic<bool> stopping;
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    std::chrono::steady_clock::time_point stats_start;
+};
+
+class TaskGroup
+{
+  public:
+    TaskGroup() : remaining(0) {}
+    ~TaskGroup() { wait();}
+    void run(std::function<void()> work);
+    void wait();
+      // We prevent a TaskGroup object from being copied or assigned
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+  private:
+    friend class ThreadPool;
+    std::atomic<int> remaining;
+};
+
+#endif // THREADPOOL_INCLUDED
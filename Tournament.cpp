@@ -0,0 +1,574 @@
+//
+//  Tournament.cpp
+//  Battleship
+//
+
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "Corpus.h"
+#include "ThreadPool.h"
+#include "globals.h"
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <unistd.h>
+#include <algorithm>
+
+using namespace std;
+
+//*********************************************************************
+//  RunningStat and SequentialTest
+//*********************************************************************
+
+RunningStat::RunningStat() : n(0), m(0), m2(0) {}
+
+void RunningStat::add(double x) {
+    ++n;
+    double delta = x - m;
+    m += delta / n;
+    m2 += delta * (x - m);
+}
+
+double RunningStat::variance() const { return n > 1 ? m2 / (n - 1) : 0;}
+
+double RunningStat::std_error() const { return n > 0 ? sqrt(variance() / n) : 0;}
+
+
+SequentialTest::SequentialTest(double delta, double alpha, double beta) : log_ratio(0) {
+    double p0 = 0.5 - delta;
+    double p1 = 0.5 + delta;
+    win_step  = log(p1 / p0);
+    loss_step = log((1 - p1) / (1 - p0));
+    upper = log((1 - beta) / alpha);
+    lower = log(beta / (1 - alpha));
+}
+
+void SequentialTest::add(bool firstWon) { log_ratio += firstWon ? win_step : loss_step;}
+
+SequentialTest::Decision SequentialTest::decision() const {
+    if (log_ratio >= upper) {return FIRST_STRONGER;}
+    if (log_ratio <= lower) {return SECOND_STRONGER;}
+    return UNDECIDED;
+}
+
+
+//*********************************************************************
+//  Tournament
+//*********************************************************************
+
+// swallows everything written to it, so games can be played without printing boards
+class NullBuffer : public streambuf
+{
+  protected:
+    int overflow(int c) override { return c;}
+};
+
+// points cout at a NullBuffer for as long as it exists
+class QuietOutput
+{
+  public:
+    QuietOutput() : old_buffer(cout.rdbuf(&null_buffer)) {}
+    ~QuietOutput() { cout.rdbuf(old_buffer);}
+  private:
+    NullBuffer null_buffer;
+    streambuf* old_buffer;
+};
+
+Tournament::Tournament(string firstType, string secondType, int nRows, int nCols, FleetSetup _fleet,
+                       unsigned int _seed)
+ : rows(nRows), cols(nCols), fleet(_fleet), seed(_seed), checkpoint_every(0), games(0), layouts(0) {
+    time_control.moveMillis = time_control.totalMillis = time_control.incrementMillis = 0;
+    types[0] = firstType;
+    types[1] = secondType;
+    wins[0] = wins[1] = 0;
+}
+
+GameRecord Tournament::play_game(long index) const {
+    /*
+     plays one game, the players swap who attacks first every game
+     so neither type gets the first move advantage.
+     The game prints as usual, run() is what keeps the output quiet
+     */
+    GameRecord result = {-1, 0};
+    seedRandom(game_seed(index));
+    Game g(rows, cols);
+    if (!fleet(g)) {return result;}
+    g.setTimeControl(time_control);
+    Player* players[2] = { createPlayer(types[0], "First " + types[0], g),
+                           createPlayer(types[1], "Second " + types[1], g) };
+    if (players[0] == nullptr || players[1] == nullptr) {
+        delete players[0];
+        delete players[1];
+        return result;
+    }
+
+    Player* winner = (index % 2 == 0 ? g.play(players[0], players[1], false) : g.play(players[1], players[0], false));
+
+    if (winner == players[0])      {result.winner = 0;}
+    else if (winner == players[1]) {result.winner = 1;}
+    result.turns = g.turnsTaken();
+    delete players[0];
+    delete players[1];
+    return result;
+}
+
+unsigned int Tournament::game_seed(long index) const {
+    // splitmix64 of the tournament seed and the game index, so neighboring games get unrelated seeds
+    uint64_t z = (static_cast<uint64_t>(seed) << 32) + static_cast<uint64_t>(index) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<unsigned int>(z ^ (z >> 31));
+}
+
+void Tournament::record(long index, const GameRecord& r) {
+    if (index >= static_cast<long>(completed.size())) { completed.resize(index + 1, false);}
+    completed[index] = true;
+    ++games;
+    if (r.winner < 0) {return;}
+    ++wins[r.winner];
+    turns[r.winner].add(r.turns);
+    test.add(r.winner == 0);
+}
+
+bool Tournament::is_decided() const {
+    /*
+     decided once the SPRT has made a call on the win rate, and, if both players have won enough games
+     to say anything about how fast they win, the 95% interval on the difference in mean turns-to-win
+     either excludes zero or is narrower than half a turn either way
+     */
+    if (test.decision() == SequentialTest::UNDECIDED) {return false;}
+    if (turns[0].count() < 10 || turns[1].count() < 10) {return true;}
+    double difference = turns[0].mean() - turns[1].mean();
+    double half_width = 1.96 * sqrt(turns[0].std_error()*turns[0].std_error() + turns[1].std_error()*turns[1].std_error());
+    return fabs(difference) > half_width || half_width < 0.5;
+}
+
+void Tournament::play_games(const vector<long>& indices, vector<GameRecord>& results) const {
+    // plays the given games in parallel on the shared ThreadPool, results[k] is the result of game indices[k]
+    results.resize(indices.size());
+    TaskGroup group;
+    for (size_t k = 0, N = indices.size(); k < N; ++k) {
+        group.run([this, k, &indices, &results] { results[k] = play_game(indices[k]);});
+    }
+    group.wait();
+}
+
+long Tournament::run(long maxGames, bool sequential) {
+    /*
+     plays until maxGames games have been recorded in total (counting any from a resumed checkpoint),
+     or, if sequential, until is_decided(). Returns the total number of games recorded.
+     Games already marked completed are skipped, and a checkpoint is saved every checkpoint_every games.
+     
+     Games are played in parallel on the shared ThreadPool, a window of a few games per thread at a time.
+     Results are still recorded in order of game index, and the window stops being recorded as soon as
+     the match is decided, so the statistics come out the same as playing the games one by one
+     */
+    QuietOutput quiet;
+    const long WINDOW = 2 * (ThreadPool::instance().workers() + 1);
+    long index = 0;
+    while (games < maxGames && !(sequential && is_decided())) {
+        vector<long> indices;
+        while (static_cast<long>(indices.size()) < min(WINDOW, maxGames - games)) {
+            while (index < static_cast<long>(completed.size()) && completed[index]) {++index;}
+            indices.push_back(index++);
+        }
+        vector<GameRecord> results;
+        play_games(indices, results);
+        for (size_t k = 0, N = indices.size(); k < N; ++k) {
+            if (sequential && is_decided()) {break;}
+            record(indices[k], results[k]);
+            if (checkpoint_every > 0 && games % checkpoint_every == 0) { save_checkpoint();}
+        }
+    }
+    if (checkpoint_every > 0) { save_checkpoint();}
+    return games;
+}
+
+void Tournament::report() const {
+    cout << games << " games played" << endl;
+    for (int k = 0; k < 2; ++k) {
+        cout << "  " << types[k] << " won " << wins[k] << " games";
+        if (turns[k].count() > 0) {
+            cout << ", in " << turns[k].mean() << " +/- " << 1.96 * turns[k].std_error() << " turns on average";
+        }
+        cout << endl;
+    }
+    switch (test.decision()) {
+        case SequentialTest::FIRST_STRONGER:  cout << "  Decided: " << types[0] << " is stronger"; break;
+        case SequentialTest::SECOND_STRONGER: cout << "  Decided: " << types[1] << " is stronger"; break;
+        default:                              cout << "  Undecided"; break;
+    }
+    cout << " (log likelihood ratio " << test.llr() << ")" << endl;
+}
+
+
+//*********************************************************************
+//  Paired comparison on a layout corpus
+//*********************************************************************
+
+int Tournament::play_layout(const LayoutCorpus& corpus, long layout, int which) const {
+    /*
+     has type `which` attack a CorpusPlayer holding the given layout and returns how many turns it took to sink every ship.
+     The game is one sided (see Game::setOneSided): the corpus player never fires back, so only the AI's attacks count,
+     and where the AI put its own ships makes no difference. The game's first step places both fleets, and the
+     random sequence is restarted from the layout number after it, so both types attack on the same random numbers
+     however differently their placements drew on them. An AI that doesn't finish (on time, or past rows*cols turns)
+     is scored as if it took every cell
+     */
+    seedRandom(static_cast<unsigned int>(layout));
+    Game g(rows, cols);
+    if (!fleet(g)) {return rows*cols;}
+    g.setTimeControl(time_control);
+    g.setOneSided(true);
+    Player* ai = createPlayer(types[which], types[which], g);
+    Player* target = createCorpusPlayer(corpus, layout, "Corpus", g);
+    int result = rows*cols;
+    if (ai != nullptr) {
+        QuietOutput quiet;
+        if (g.start(ai, target, false) && g.step() != GAME_OVER) {
+            seedRandom(static_cast<unsigned int>(layout));
+            if (g.finish() == ai) {result = g.turnsTaken();}
+        }
+    }
+    delete ai;
+    delete target;
+    return result;
+}
+
+long Tournament::run_paired(const LayoutCorpus& corpus, long maxLayouts, bool sequential) {
+    // returns how many layouts were played
+    long played = 0;
+    while (played < maxLayouts && layouts < corpus.size()) {
+        int first  = play_layout(corpus, layouts, 0);
+        int second = play_layout(corpus, layouts, 1);
+        layout_turns[0].add(first);
+        layout_turns[1].add(second);
+        paired_difference.add(first - second);
+        ++layouts;
+        ++played;
+        if (sequential && is_paired_decided()) {break;}
+    }
+    return played;
+}
+
+bool Tournament::is_paired_decided() const {
+    // same rule as the turns part of is_decided(), but on the per-layout differences
+    if (paired_difference.count() < 10) {return false;}
+    double half_width = 1.96 * paired_difference.std_error();
+    return fabs(paired_difference.mean()) > half_width || half_width < 0.5;
+}
+
+void Tournament::report_paired() const {
+    cout << layouts << " layouts played by each player" << endl;
+    for (int k = 0; k < 2; ++k) {
+        cout << "  " << types[k] << " took " << layout_turns[k].mean() << " +/- "
+             << 1.96 * layout_turns[k].std_error() << " turns on average" << endl;
+    }
+    cout << "  Paired difference: " << paired_difference.mean() << " +/- "
+         << 1.96 * paired_difference.std_error() << " turns" << endl;
+    if (paired_difference.variance() > 0) {
+        // how many times more games unpaired testing would need for the same interval
+        cout << "  Pairing reduced the variance by a factor of "
+             << (layout_turns[0].variance() + layout_turns[1].variance()) / paired_difference.variance() << endl;
+    }
+}
+
+
+//*********************************************************************
+//  Checkpoints
+//*********************************************************************
+
+/*
+ Checkpoint file (native byte order, so only meant to be read back on the same machine):
+     "BSTP", format version, sizeof(double)
+     seed, rows, cols, and both player types
+     games, wins, turns-to-win stats and the SPRT's log likelihood ratio
+     layouts and the paired comparison stats
+     the completed set, as a count followed by one byte per game index
+ It is written to a temporary file first and then renamed over the old one,
+ so a crash part way through a save leaves the previous checkpoint intact.
+ */
+
+const uint32_t CHECKPOINT_VERSION = 1;
+
+static void write_bytes(FILE* f, const void* p, size_t n) { fwrite(p, 1, n, f);}
+static bool read_bytes(FILE* f, void* p, size_t n) { return fread(p, 1, n, f) == n;}
+
+template<typename T> static void write_value(FILE* f, const T& x) { write_bytes(f, &x, sizeof(T));}
+template<typename T> static bool read_value(FILE* f, T& x) { return read_bytes(f, &x, sizeof(T));}
+
+static void write_string(FILE* f, const string& s) {
+    write_value(f, static_cast<uint32_t>(s.size()));
+    write_bytes(f, s.data(), s.size());
+}
+
+static bool read_string(FILE* f, string& s) {
+    uint32_t n;
+    if (!read_value(f, n) || n > 1024) {return false;}
+    s.resize(n);
+    return n == 0 || read_bytes(f, &s[0], n);
+}
+
+void Tournament::set_time_control(const TimeControl& tc) { time_control = tc;}
+
+void Tournament::set_checkpoint(const string& path, long everyGames) {
+    checkpoint_path = path;
+    checkpoint_every = everyGames;
+}
+
+bool Tournament::save_checkpoint() const {
+    if (checkpoint_path.empty()) {return false;}
+    string temporary = checkpoint_path + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr) {return false;}
+
+    write_bytes(f, "BSTP", 4);
+    write_value(f, CHECKPOINT_VERSION);
+    write_value(f, static_cast<uint32_t>(sizeof(double)));
+    write_value(f, seed);
+    write_value(f, rows);
+    write_value(f, cols);
+    write_string(f, types[0]);
+    write_string(f, types[1]);
+
+    write_value(f, games);
+    for (int k = 0; k < 2; ++k) {
+        write_value(f, wins[k]);
+        write_value(f, turns[k].n);
+        write_value(f, turns[k].m);
+        write_value(f, turns[k].m2);
+    }
+    write_value(f, test.log_ratio);
+
+    write_value(f, layouts);
+    const RunningStat* paired[3] = { &layout_turns[0], &layout_turns[1], &paired_difference };
+    for (int k = 0; k < 3; ++k) {
+        write_value(f, paired[k]->n);
+        write_value(f, paired[k]->m);
+        write_value(f, paired[k]->m2);
+    }
+
+    write_value(f, static_cast<uint64_t>(completed.size()));
+    for (size_t i = 0, N = completed.size(); i < N; ++i) { fputc(completed[i] ? 1 : 0, f);}
+
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(temporary.c_str(), checkpoint_path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Tournament::resume(const string& path) {
+    /*
+     loads a checkpoint written by save_checkpoint(), but only if it belongs to this tournament
+     (same seed, board size and player types). On any mismatch or read error nothing is changed.
+     Also sets the checkpoint path, so the resumed run keeps saving to the same file
+     */
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {return false;}
+
+    Tournament loaded(types[0], types[1], rows, cols, fleet, seed);
+    char magic[4];
+    uint32_t version, double_size;
+    unsigned int file_seed;
+    int file_rows, file_cols;
+    string file_types[2];
+    bool ok = read_bytes(f, magic, 4) && magic[0] == 'B' && magic[1] == 'S' && magic[2] == 'T' && magic[3] == 'P' &&
+              read_value(f, version) && version == CHECKPOINT_VERSION &&
+              read_value(f, double_size) && double_size == sizeof(double) &&
+              read_value(f, file_seed) && file_seed == seed &&
+              read_value(f, file_rows) && file_rows == rows &&
+              read_value(f, file_cols) && file_cols == cols &&
+              read_string(f, file_types[0]) && file_types[0] == types[0] &&
+              read_string(f, file_types[1]) && file_types[1] == types[1];
+
+    ok = ok && read_value(f, loaded.games);
+    for (int k = 0; ok && k < 2; ++k) {
+        ok = read_value(f, loaded.wins[k]) && read_value(f, loaded.turns[k].n) &&
+             read_value(f, loaded.turns[k].m) && read_value(f, loaded.turns[k].m2);
+    }
+    ok = ok && read_value(f, loaded.test.log_ratio) && read_value(f, loaded.layouts);
+    RunningStat* paired[3] = { &loaded.layout_turns[0], &loaded.layout_turns[1], &loaded.paired_difference };
+    for (int k = 0; ok && k < 3; ++k) {
+        ok = read_value(f, paired[k]->n) && read_value(f, paired[k]->m) && read_value(f, paired[k]->m2);
+    }
+    uint64_t n_completed = 0;
+    ok = ok && read_value(f, n_completed);
+    for (uint64_t i = 0; ok && i < n_completed; ++i) {
+        int c = fgetc(f);
+        ok = c != EOF;
+        loaded.completed.push_back(c == 1);
+    }
+    fclose(f);
+    if (!ok) {return false;}
+
+    games = loaded.games;
+    wins[0] = loaded.wins[0];
+    wins[1] = loaded.wins[1];
+    turns[0] = loaded.turns[0];
+    turns[1] = loaded.turns[1];
+    test = loaded.test;
+    layouts = loaded.layouts;
+    layout_turns[0] = loaded.layout_turns[0];
+    layout_turns[1] = loaded.layout_turns[1];
+    paired_difference = loaded.paired_difference;
+    completed = loaded.completed;
+    checkpoint_path = path;
+    return true;
+}
+
+
+//*********************************************************************
+//  Shards
+//*********************************************************************
+
+/*
+ Shard file (little endian throughout, so shards can be played on one machine and merged on another):
+     "BSSH", format version (4 bytes)
+     seed (4 bytes), rows, cols (1 byte each), and both player types (4 byte length, then the characters)
+     index of the first game and number of games (8 bytes each)
+     then 3 bytes per game, in index order: winner + 1, and the winner's turns (2 bytes)
+ Like a checkpoint, it is written to a temporary file and renamed into place once it is complete,
+ so a shard file that exists is a finished shard.
+ */
+
+const uint32_t SHARD_VERSION = 1;
+const size_t SHARD_RECORD_SIZE = 3;
+
+static void write_le(FILE* f, uint64_t x, int nBytes) {
+    for (int i = 0; i < nBytes; ++i) { fputc(static_cast<int>((x >> (8*i)) & 0xFF), f);}
+}
+
+static bool read_le(FILE* f, uint64_t& x, int nBytes) {
+    x = 0;
+    for (int i = 0; i < nBytes; ++i) {
+        int c = fgetc(f);
+        if (c == EOF) {return false;}
+        x |= static_cast<uint64_t>(c) << (8*i);
+    }
+    return true;
+}
+
+static void write_le_string(FILE* f, const string& s) {
+    write_le(f, s.size(), 4);
+    write_bytes(f, s.data(), s.size());
+}
+
+static bool read_le_string(FILE* f, string& s) {
+    uint64_t n;
+    if (!read_le(f, n, 4) || n > 1024) {return false;}
+    s.resize(n);
+    return n == 0 || read_bytes(f, &s[0], n);
+}
+
+bool Tournament::run_shard(long first, long last, const string& path) const {
+    /*
+     plays games first through last - 1 of this tournament and writes their results to a shard file.
+     Nothing is recorded here: a shard only holds per game results,
+     and merge_shards() records them in index order, exactly as run() would have
+     */
+    if (first < 0 || last < first) {return false;}
+    vector<GameRecord> results;
+    {
+        QuietOutput quiet;
+        const long WINDOW = 2 * (ThreadPool::instance().workers() + 1);
+        for (long start = first; start < last; start += WINDOW) {
+            vector<long> indices;
+            for (long i = start; i < min(start + WINDOW, last); ++i) { indices.push_back(i);}
+            vector<GameRecord> window;
+            play_games(indices, window);
+            results.insert(results.end(), window.begin(), window.end());
+        }
+    }
+
+    string temporary = path + ".tmp";
+    FILE* f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr) {return false;}
+    write_bytes(f, "BSSH", 4);
+    write_le(f, SHARD_VERSION, 4);
+    write_le(f, seed, 4);
+    write_le(f, rows, 1);
+    write_le(f, cols, 1);
+    write_le_string(f, types[0]);
+    write_le_string(f, types[1]);
+    write_le(f, first, 8);
+    write_le(f, last - first, 8);
+    for (size_t i = 0, N = results.size(); i < N; ++i) {
+        write_le(f, results[i].winner + 1, 1);
+        write_le(f, results[i].turns, 2);
+    }
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+long Tournament::merge_shards(const vector<string>& paths, bool sequential) {
+    /*
+     records the games of every shard file, in index order, stopping early if sequential and is_decided().
+     The shards have to belong to this tournament and fit together into games 0 through n - 1
+     with no gaps or overlaps, in any order, and this tournament can't have recorded any games yet.
+     Returns the number of games recorded, or -1 if the shards don't fit (in which case nothing is recorded)
+     or a read fails part way. The result is the same as run(n, sequential) in a single process
+     */
+    struct Shard
+    {
+        FILE* file;
+        uint64_t first;
+        uint64_t count;
+        bool operator<(const Shard& other) const { return first < other.first;}
+    };
+    if (games > 0) {return -1;}
+    vector<Shard> shards;
+    bool ok = true;
+    for (size_t k = 0, N = paths.size(); ok && k < N; ++k) {
+        Shard shard = { fopen(paths[k].c_str(), "rb"), 0, 0 };
+        if (shard.file == nullptr) { ok = false; break;}
+        shards.push_back(shard);
+        char magic[4];
+        uint64_t version, file_seed, file_rows, file_cols;
+        string file_types[2];
+        ok = read_bytes(shard.file, magic, 4) && magic[0] == 'B' && magic[1] == 'S' && magic[2] == 'S' && magic[3] == 'H' &&
+             read_le(shard.file, version, 4) && version == SHARD_VERSION &&
+             read_le(shard.file, file_seed, 4) && file_seed == seed &&
+             read_le(shard.file, file_rows, 1) && static_cast<int>(file_rows) == rows &&
+             read_le(shard.file, file_cols, 1) && static_cast<int>(file_cols) == cols &&
+             read_le_string(shard.file, file_types[0]) && file_types[0] == types[0] &&
+             read_le_string(shard.file, file_types[1]) && file_types[1] == types[1] &&
+             read_le(shard.file, shards.back().first, 8) && read_le(shard.file, shards.back().count, 8);
+
+        // and the file has to hold every game it claims to, so a merge can't stop part way through a shard
+        long header_end = ftell(shard.file);
+        ok = ok && fseek(shard.file, 0, SEEK_END) == 0 &&
+             static_cast<uint64_t>(ftell(shard.file) - header_end) == SHARD_RECORD_SIZE * shards.back().count &&
+             fseek(shard.file, header_end, SEEK_SET) == 0;
+    }
+    sort(shards.begin(), shards.end());
+    uint64_t expected = 0;
+    for (size_t k = 0, N = shards.size(); ok && k < N; ++k) {
+        ok = shards[k].first == expected;
+        expected += shards[k].count;
+    }
+
+    for (size_t k = 0, N = shards.size(); ok && k < N && !(sequential && is_decided()); ++k) {
+        for (uint64_t i = 0; i < shards[k].count; ++i) {
+            if (sequential && is_decided()) {break;}
+            uint64_t winner, turns_taken;
+            if (!read_le(shards[k].file, winner, 1) || !read_le(shards[k].file, turns_taken, 2) || winner > 2) {
+                ok = false;
+                break;
+            }
+            GameRecord r = { static_cast<int>(winner) - 1, static_cast<int>(turns_taken) };
+            record(static_cast<long>(shards[k].first + i), r);
+        }
+    }
+    for (size_t k = 0, N = shards.size(); k < N; ++k) { fclose(shards[k].file);}
+    return ok ? games : -1;
+}
@@ -0,0 +1,141 @@
+//
+//  Tournament.h
+//  Battleship
+//
+
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include "Game.h"
+#include <string>
+#include <vector>
+
+/*
+ Tournament plays a long match between two kinds of AI player (by their createPlayer type strings)
+ without printing every board, and keeps its statistics as it goes.
+
+ Rather than picking a number of games by hand, run() can be asked to stop as soon as the answer is clear:
+ the win rate is tracked by a sequential probability ratio test (SequentialTest),
+ and the turns it takes each player to win are tracked by running means (RunningStat),
+ which are compared with a 95% confidence interval.
+ Nothing is stored per game, so memory use doesn't grow with the number of games.
+
+ run_paired() is the low variance alternative: instead of playing the two types against each other,
+ each type attacks every layout of a LayoutCorpus (see Corpus.h) with the same random seed,
+ and the per-layout difference in turns-to-win is what gets averaged.
+
+ Every game is played from its own seed, worked out from the tournament's seed and the game's index,
+ so a game's result doesn't depend on what was played before it.
+ That lets a long run be checkpointed: set_checkpoint() has run() save the statistics,
+ the seed and the set of finished games every so often, and resume() picks a run back up from that file.
+ A resumed run plays the same games in the same order as one that was never stopped, and ends with the same numbers
+ (as long as no GoodPlayer move hit its time limit, since that depends on the clock rather than the seed).
+
+ set_time_control() puts every game of the match under a clock (see TimeControl in Game.h),
+ so players of very different cost can be compared on the same time; a player over its limit loses that game.
+ Results then depend on the machine as well as the seed, and the time control isn't saved in checkpoints or shards.
+
+ run() plays its games in parallel on the shared ThreadPool (see ThreadPool.h), but records them in index order.
+
+ The same property lets one match be split over several processes, or several machines:
+ run_shard() plays games i through j - 1 and writes their results to a shard file,
+ and merge_shards() reads a set of shard files covering games 0 through n - 1 and records them in index order.
+ The merged statistics are exactly those of run(n, sequential) in one process,
+ since it is the same games recorded in the same order. The only coordination is the files themselves.
+ That holds for every player type, good and entropy included, however many worker threads each process has
+ (the "check" command in main.cpp tests exactly that), with two exceptions:
+ a match under a time control, and a GoodPlayer or EntropyPlayer move that hits its 3.9 second limit.
+ Those depend on the clock, and a shard doesn't record whether it happened.
+ */
+
+class LayoutCorpus;
+
+typedef bool (*FleetSetup)(Game& g);
+
+class RunningStat
+{
+    // Welford's streaming mean and variance
+    friend class Tournament;
+  public:
+    RunningStat();
+    void add(double x);
+    long count() const { return n;}
+    double mean() const { return m;}
+    double variance() const;
+    double std_error() const;
+  private:
+    long n;
+    double m;
+    double m2;
+};
+
+class SequentialTest
+{
+    /*
+     Wald's SPRT on the first player's win rate p,
+     testing p = 0.5 - delta (second player stronger) against p = 0.5 + delta (first player stronger)
+     alpha and beta are the chances of wrongly calling either one
+     */
+    friend class Tournament;
+  public:
+    enum Decision { UNDECIDED, FIRST_STRONGER, SECOND_STRONGER };
+    SequentialTest(double delta = 0.05, double alpha = 0.05, double beta = 0.05);
+    void add(bool firstWon);
+    Decision decision() const;
+    double llr() const { return log_ratio;}
+  private:
+    double win_step;
+    double loss_step;
+    double upper;
+    double lower;
+    double log_ratio;
+};
+
+struct GameRecord
+{
+    int winner; // 0 for the first player, 1 for the second, -1 if nobody won
+    int turns;  // attacks made by the winner
+};
+
+class Tournament
+{
+  public:
+    Tournament(std::string firstType, std::string secondType, int nRows, int nCols, FleetSetup fleet,
+               unsigned int seed = 1);
+    GameRecord play_game(long index) const;
+    void record(long index, const GameRecord& r);
+    long run(long maxGames, bool sequential);
+    void set_time_control(const TimeControl& tc);
+    void set_checkpoint(const std::string& path, long everyGames);
+    bool save_checkpoint() const;
+    bool resume(const std::string& path);
+    bool is_decided() const;
+    void report() const;
+    int play_layout(const LayoutCorpus& corpus, long layout, int which) const;
+    long run_paired(const LayoutCorpus& corpus, long maxLayouts, bool sequential);
+    bool is_paired_decided() const;
+    void report_paired() const;
+    bool run_shard(long first, long last, const std::string& path) const;
+    long merge_shards(const std::vector<std::string>& paths, bool sequential);
+  private:
+    void play_games(const std::vector<long>& indices, std::vector<GameRecord>& results) const;
+    unsigned int game_seed(long index) const;
+    std::string types[2];
+    int rows;
+    int cols;
+    FleetSetup fleet;
+    unsigned int seed;
+    TimeControl time_control;
+    std::string checkpoint_path;
+    long checkpoint_every;
+    std::vector<bool> completed;     // completed[i] is true once game i has been recorded
+    long games;
+    long wins[2];
+    RunningStat turns[2];
+    SequentialTest test;
+    long layouts;
+    RunningStat layout_turns[2];
+    RunningStat paired_difference;
+};
+
+#endif // TOURNAMENT_INCLUDED
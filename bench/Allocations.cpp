@@ -0,0 +1,91 @@
+//
+//  Allocations.cpp
+//  Battleship
+//
+
+/*
+ Counts the heap allocations a game makes, played headless (CompactGame, see Simulation.h) and through Game::play.
+ It replaces the global operator new and delete to count them, which is why it is a program of its own
+ rather than part of the game: every form is replaced (plain, array, nothrow, aligned and sized),
+ and nothing else ever runs with them. Build it from the top directory with everything but main.cpp:
+     g++ -std=c++17 -O2 -pthread -o allocations bench/Allocations.cpp $(ls *.cpp | grep -v main.cpp)
+ */
+
+#include "../Game.h"
+#include "../Simulation.h"
+#include "../Tournament.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+static atomic<long> allocation_count(0);
+
+static void* counted_alloc(size_t size, size_t alignment) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (size == 0) {size = 1;}
+    if (alignment <= alignof(max_align_t)) {return malloc(size);}
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+static void* counted_new(size_t size, size_t alignment) {
+    void* p = counted_alloc(size, alignment);
+    if (p == nullptr) {throw bad_alloc();}
+    return p;
+}
+
+void* operator new(size_t size) { return counted_new(size, 0);}
+void* operator new[](size_t size) { return counted_new(size, 0);}
+void* operator new(size_t size, const nothrow_t&) noexcept { return counted_alloc(size, 0);}
+void* operator new[](size_t size, const nothrow_t&) noexcept { return counted_alloc(size, 0);}
+void* operator new(size_t size, align_val_t a) { return counted_new(size, static_cast<size_t>(a));}
+void* operator new[](size_t size, align_val_t a) { return counted_new(size, static_cast<size_t>(a));}
+void* operator new(size_t size, align_val_t a, const nothrow_t&) noexcept { return counted_alloc(size, static_cast<size_t>(a));}
+void* operator new[](size_t size, align_val_t a, const nothrow_t&) noexcept { return counted_alloc(size, static_cast<size_t>(a));}
+
+// malloc and posix_memalign memory are both given back with free, so every delete is the same
+void operator delete(void* p) noexcept { free(p);}
+void operator delete[](void* p) noexcept { free(p);}
+void operator delete(void* p, size_t) noexcept { free(p);}
+void operator delete[](void* p, size_t) noexcept { free(p);}
+void operator delete(void* p, const nothrow_t&) noexcept { free(p);}
+void operator delete[](void* p, const nothrow_t&) noexcept { free(p);}
+void operator delete(void* p, align_val_t) noexcept { free(p);}
+void operator delete[](void* p, align_val_t) noexcept { free(p);}
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p);}
+void operator delete[](void* p, size_t, align_val_t) noexcept { free(p);}
+void operator delete(void* p, align_val_t, const nothrow_t&) noexcept { free(p);}
+void operator delete[](void* p, align_val_t, const nothrow_t&) noexcept { free(p);}
+
+static bool addStandardShips(Game& g) {
+    return g.addShip(5, 'A', "aircraft carrier") && g.addShip(4, 'B', "battleship") && g.addShip(3, 'D', "destroyer") &&
+           g.addShip(3, 'S', "submarine") && g.addShip(2, 'P', "patrol boat");
+}
+
+int main() {
+    const size_t NGAMES = 100000;
+    const long NCLASSIC = 100;
+    Game g(10, 10);
+    addStandardShips(g);
+    SimulationFleet fleet;
+    fleet.configure(g);
+    vector<CompactGame> games(NGAMES);
+
+    long allocations = allocation_count;
+    long firstWins = simulate_games(fleet, SIM_HUNT, SIM_HUNT, games.data(), NGAMES, 1);
+    allocations = allocation_count - allocations;
+    cout << "CompactGame: " << static_cast<double>(allocations) / NGAMES << " heap allocations per game"
+         << " (the first player won " << firstWins << " of " << NGAMES << ")" << endl;
+
+    Tournament t("mediocre", "mediocre", 10, 10, addStandardShips);
+    allocations = allocation_count;
+    t.run(NCLASSIC, false);
+    allocations = allocation_count - allocations;
+    cout << "Game::play:  " << static_cast<double>(allocations) / NCLASSIC << " heap allocations per game" << endl;
+    return 0;
+}
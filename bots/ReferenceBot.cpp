@@ -0,0 +1,168 @@
+//
+//  ReferenceBot.cpp
+//  Battleship
+//
+
+/*
+ A bot for BotPlayer, as a starting point for writing others.
+ It only uses BotProtocol.h, so it builds on its own:
+     g++ -std=c++17 -O2 -o reference_bot bots/ReferenceBot.cpp
+ and is started by the game as  reference_bot <shared memory name>
+
+ It places every ship at a random spot (straight ships either way, other shapes as they come),
+ and attacks like a simple hunt and target player: random cells of one parity until something is hit,
+ then the untried neighbors of its hits until they run out.
+ */
+
+#include "../BotProtocol.h"
+#include <random>
+#include <vector>
+
+using namespace std;
+
+struct Ship
+{
+    int length;
+    int orientations;
+    vector<int> rows;
+    vector<int> cols;
+};
+
+class ReferenceBot
+{
+  public:
+    ReferenceBot(int nRows, int nCols) : rows(nRows), cols(nCols), tried(nRows*nCols, false), generator(random_device{}()) {}
+    vector<Ship> ships;
+    bool place(vector<BotMessage>& placements);
+    BotMessage attack();
+    void result(int r, int c, bool valid, bool hit);
+  private:
+    int random(int limit) { return uniform_int_distribution<>(0, limit - 1)(generator);}
+    int rows;
+    int cols;
+    vector<bool> tried;
+    vector<int> targets;    // untried neighbors of hits, tried last in first out
+    mt19937 generator;
+};
+
+bool ReferenceBot::place(vector<BotMessage>& placements) {
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        vector<bool> used(rows*cols, false);
+        placements.clear();
+        bool placed = true;
+        for (size_t s = 0; s < ships.size() && placed; ++s) {
+            const Ship& ship = ships[s];
+            placed = false;
+            for (int tries = 0; tries < 100 && !placed; ++tries) {
+                bool straight = true;
+                for (int i = 0; i < ship.length; ++i) { straight = straight && ship.rows[i] == 0;}
+                bool down = straight && random(2) == 1;     // orientation 1 of a straight ship, its cells transposed
+                int r0 = random(rows), c0 = random(cols);
+                bool fits = true;
+                for (int i = 0; i < ship.length && fits; ++i) {
+                    int r = r0 + (down ? ship.cols[i] : ship.rows[i]);
+                    int c = c0 + (down ? ship.rows[i] : ship.cols[i]);
+                    fits = r < rows && c < cols && !used[r*cols + c];
+                }
+                if (!fits) {continue;}
+                for (int i = 0; i < ship.length; ++i) {
+                    used[(r0 + (down ? ship.cols[i] : ship.rows[i]))*cols + c0 + (down ? ship.rows[i] : ship.cols[i])] = true;
+                }
+                BotMessage m = bot_message(BOT_PLACEMENT);
+                m.value[0] = static_cast<int32_t>(s);
+                m.value[1] = r0;
+                m.value[2] = c0;
+                m.value[3] = down ? 1 : 0;
+                placements.push_back(m);
+                placed = true;
+            }
+        }
+        if (placed) {return true;}
+    }
+    return false;
+}
+
+BotMessage ReferenceBot::attack() {
+    BotMessage m = bot_message(BOT_ATTACK);
+    while (!targets.empty() && tried[targets.back()]) { targets.pop_back();}
+    int cell = -1;
+    if (!targets.empty()) { cell = targets.back();}
+    else {
+        // a random untried cell of even parity, or of any parity once those are gone
+        vector<int> untried[2];
+        for (int i = 0; i < rows*cols; ++i) {
+            if (!tried[i]) { untried[(i / cols + i % cols) % 2].push_back(i);}
+        }
+        const vector<int>& choices = untried[0].empty() ? untried[1] : untried[0];
+        cell = choices.empty() ? 0 : choices[random(static_cast<int>(choices.size()))];
+    }
+    m.value[0] = cell / cols;
+    m.value[1] = cell % cols;
+    return m;
+}
+
+void ReferenceBot::result(int r, int c, bool valid, bool hit) {
+    if (r < 0 || r >= rows || c < 0 || c >= cols) {return;}
+    tried[r*cols + c] = true;
+    if (!valid || !hit) {return;}
+    const int dr[4] = {-1, 0, 1, 0};
+    const int dc[4] = {0, 1, 0, -1};
+    for (int d = 0; d < 4; ++d) {
+        int rr = r + dr[d], cc = c + dc[d];
+        if (rr >= 0 && rr < rows && cc >= 0 && cc < cols && !tried[rr*cols + cc]) { targets.push_back(rr*cols + cc);}
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {return 1;}
+    BotChannel* channel = bot_open_channel(argv[1]);
+    if (channel == nullptr) {return 1;}
+
+    // the game started us, so once our parent changes the game is gone
+    pid_t game = getppid();
+    auto alive = [game] { return getppid() == game;};
+    BotMessage m;
+    if (!bot_receive(channel->to_bot, m, alive) || m.type != BOT_HELLO) {return 1;}
+    ReferenceBot bot(m.value[0], m.value[1]);
+    bot.ships.resize(m.value[2]);
+
+    vector<BotMessage> placements;
+    while (bot_receive(channel->to_bot, m, alive)) {
+        switch (m.type) {
+          case BOT_SHIP: {
+            Ship& ship = bot.ships[m.value[0]];
+            ship.length = m.value[2];
+            ship.orientations = m.value[3];
+            for (int i = m.value[4]; i < ship.length && i < m.value[4] + BOT_CELLS_PER_SHIP_MESSAGE; ++i) {
+                ship.rows.push_back(m.value[5 + i - m.value[4]] >> 8);
+                ship.cols.push_back(m.value[5 + i - m.value[4]] & 0xFF);
+            }
+            if (m.value[0] + 1 == static_cast<int>(bot.ships.size()) && static_cast<int>(ship.rows.size()) == ship.length) {
+                bot_send(channel->to_game, bot_message(BOT_READY), alive);
+            }
+            break;
+          }
+          case BOT_PLACE_SHIPS:
+            if (!bot.place(placements)) { bot_send(channel->to_game, bot_message(BOT_PLACEMENT_FAILED), alive); break;}
+            for (size_t i = 0; i < placements.size(); ++i) { bot_send(channel->to_game, placements[i], alive);}
+            break;
+          case BOT_RECOMMEND:
+            bot_send(channel->to_game, bot.attack(), alive);
+            break;
+          case BOT_ATTACK_RESULT:
+            bot.result(m.value[0], m.value[1], m.value[2] != 0, m.value[3] != 0);
+            break;
+          case BOT_PING:
+            bot_send(channel->to_game, bot_message(BOT_PONG), alive);
+            break;
+          case BOT_QUIT:
+            bot_close_channel(channel);
+            return 0;
+          default:
+            break;
+        }
+    }
+    bot_close_channel(channel);
+    return 0;
+}
@@ -2,10 +2,16 @@
 #define GLOBALS_INCLUDED
 
 #include <random>
+#include <bitset>
 
 const int MAXROWS = 10;
 const int MAXCOLS = 10;
+const int MAXCELLS = MAXROWS * MAXCOLS;
 
+  // A set of cells of a board, cell r*cols + c for the cell at row r, column c
+typedef std::bitset<MAXCELLS> CellSet;
+
+  // The two orientations of a straight ship, as orientation numbers (see ShipShape.h)
 enum Direction {
     HORIZONTAL, VERTICAL
 };
@@ -19,15 +25,52 @@ class Point
     int c;
 };
 
-  // Return a uniformly distributed random int from 0 to limit-1
-inline int randInt(int limit)
+  // What became of one shot of a salvo, in the terms of Board::attack and Player::recordAttackResult
+struct ShotResult
+{
+    Point p;
+    bool validShot;
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;
+};
+
+  // The generator behind randInt, seeded randomly unless seedRandom is called.
+  // Each thread has its own, so games and sampling can run on several threads at once.
+inline std::mt19937& randomGenerator()
+{
+    static thread_local std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
+  // Restart this thread's random sequence, so a run can be repeated exactly
+inline void seedRandom(unsigned int seed)
+{
+    randomGenerator().seed(seed);
+}
+
+  // Return a uniformly distributed random int from 0 to limit-1, drawn from the given generator
+inline int randInt(int limit, std::mt19937& generator)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     if (limit < 1)
         limit = 1;
     std::uniform_int_distribution<> distro(0, limit-1);
     return distro(generator);
 }
 
+  // Return a uniformly distributed random int from 0 to limit-1
+inline int randInt(int limit)
+{
+    return randInt(limit, randomGenerator());
+}
+
+  // A generator of its own for task k of a ThreadPool job (see ThreadPool.h), seeded from seed and k.
+  // Tasks can run on any thread, and a thread waiting on its own tasks runs other games' tasks too,
+  // so a task must never draw from randomGenerator(): the job draws seed from it once and hands out these instead
+inline std::mt19937 taskGenerator(unsigned int seed, unsigned int k)
+{
+    std::seed_seq sequence{seed, k};
+    return std::mt19937(sequence);
+}
+
 #endif // GLOBALS_INCLUDED
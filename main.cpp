@@ -2,8 +2,25 @@
 #include "Player.h"
 #include "globals.h"
 #include "Board.h"
+#include "Tournament.h"
+#include "Corpus.h"
+#include "Simulation.h"
+#include "BatchSimulation.h"
+#include "ThreadPool.h"
+#include "BotPlayer.h"
+#include "OpeningBook.h"
+#include "Accuracy.h"
+#include "Possibilities.h"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <thread>
 
 
 using namespace std;
@@ -25,8 +42,100 @@ bool addGoofyShips(Game& g)
            g.addShip(3, 'S', "the goofiest ship of dem all")  &&
            g.addShip(2, 'P', "Kyle's hairy poopy butt");
 }
-int main()
+string fileContents(const string& path)
 {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return "";
+    string contents;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        contents.append(buffer, n);
+    fclose(f);
+    return contents;
+}
+
+int shardCommand(int argc, char* argv[])
+{
+      // Battleship shard <type> <type> <seed> <first game> <last game + 1> <shard file>
+      // Battleship merge <type> <type> <seed> <shard file>...
+      // Battleship check <type> <type> <seed> <games>
+    string command = argv[1];
+    if (command == "shard"  &&  argc == 8)
+    {
+        Tournament t(argv[2], argv[3], 10, 10, addStandardShips, strtoul(argv[4], nullptr, 10));
+        if (!t.run_shard(atol(argv[5]), atol(argv[6]), argv[7]))
+        {
+            cout << "Could not write " << argv[7] << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (command == "merge"  &&  argc >= 6)
+    {
+        Tournament t(argv[2], argv[3], 10, 10, addStandardShips, strtoul(argv[4], nullptr, 10));
+        vector<string> paths(argv + 5, argv + argc);
+        if (t.merge_shards(paths, false) < 0)
+        {
+            cout << "The shard files are missing, belong to a different match, or don't fit together." << endl;
+            return 1;
+        }
+        t.report();
+        return 0;
+    }
+    if (command == "check"  &&  argc == 6)
+    {
+          // Battleship check <type> <type> <seed> <games>: plays the games with no worker threads,
+          // then again with several, and the two shards must come out the same byte for byte
+        Tournament t(argv[2], argv[3], 10, 10, addStandardShips, strtoul(argv[4], nullptr, 10));
+        long games = atol(argv[5]);
+        int workers = max(3, static_cast<int>(thread::hardware_concurrency()) - 1);
+        string paths[2] = { "check_0.shard", "check_" + to_string(workers) + ".shard" };
+        ThreadPool::instance().set_workers(0);
+        bool written = t.run_shard(0, games, paths[0]);
+        ThreadPool::instance().set_workers(workers);
+        written = t.run_shard(0, games, paths[1]) && written;
+        bool same = written && fileContents(paths[0]) == fileContents(paths[1]);
+        remove(paths[0].c_str());
+        remove(paths[1].c_str());
+        if (!written)
+        {
+            cout << "Could not write the shard files" << endl;
+            return 1;
+        }
+        cout << games << " games with 0 and with " << workers << " worker threads: "
+             << (same ? "the same" : "DIFFERENT") << endl;
+        return same ? 0 : 1;
+    }
+    if (command == "book"  &&  argc == 5)
+    {
+          // Battleship book <shots deep> <samples a position> <book file>, for the standard fleet
+        Game g(10, 10);
+        addStandardShips(g);
+        seedRandom(1);
+        auto start = chrono::steady_clock::now();
+        long positions = write_opening_book(g, atoi(argv[2]), atol(argv[3]), argv[4]);
+        if (positions < 0)
+        {
+            cout << "Could not write " << argv[4] << endl;
+            return 1;
+        }
+        cout << positions << " positions written to " << argv[4] << " in "
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " seconds" << endl;
+        return 0;
+    }
+    cout << "Usage: " << argv[0] << " shard <type> <type> <seed> <first> <last> <file>" << endl;
+    cout << "       " << argv[0] << " merge <type> <type> <seed> <file>..." << endl;
+    cout << "       " << argv[0] << " check <type> <type> <seed> <games>" << endl;
+    cout << "       " << argv[0] << " book <shots deep> <samples a position> <file>   (copy it to opening_book.bin to use it)" << endl;
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+        return shardCommand(argc, argv);
 
 
     
@@ -42,6 +151,28 @@ int main()
     cout << "  4.  A " << NTRIALS
          << "-game match between a mediocre and a good player, with no pauses"
          << endl;
+    cout << "  5.  A match between two AI players that stops once one is clearly stronger"
+         << endl;
+    cout << "  6.  A paired comparison of two AI players on the same layouts from a layout corpus"
+         << endl;
+    cout << "  7.  A headless simulation of a million mediocre-style games, with memory and speed figures"
+         << endl;
+    cout << "  8.  The same simulation, one game at a time and in lockstep batches, for speed"
+         << endl;
+    cout << "  9.  A match split into shards played by separate processes, then merged"
+         << endl;
+    cout << "  10. A match between a mediocre player and a bot program, with round trip timings"
+         << endl;
+    cout << "  11. A timed match between a good and an entropy player, with per-move timings"
+         << endl;
+    cout << "  12. A salvo game between a mediocre and a good player, one shot a turn for every ship afloat"
+         << endl;
+    cout << "  13. How close the probability estimators come to the exact chances, on a board small enough to count"
+         << endl;
+    cout << "  14. How fast the sampler runs as the fleet grows from 5 to 50 ships"
+         << endl;
+    cout << "  15. Games between a bot program and a mediocre player, one after another and then all at once on one thread"
+         << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin,line);
@@ -49,6 +180,285 @@ int main()
     {
         cout << "You did not enter a choice" << endl;
     }
+    else if (line == "10")
+    {
+        const int NGAMES = 20;
+        const long NPINGS = 100000;
+        string path;
+        cout << "Enter the path of the bot (build bots/ReferenceBot.cpp for one): ";
+        cin >> path;
+        int botWins = 0;
+        BotTiming timing = { 0, 0, 0 };
+        double ping = -1;
+        for (int k = 0; k < NGAMES; k++)
+        {
+            Game g(10, 10);
+            addStandardShips(g);
+            Player* bot = createPlayer("bot:" + path, "Bot", g);
+            Player* mediocre = createPlayer("mediocre", "Mediocre Mimi", g);
+            if (bot == nullptr)
+            {
+                cout << "Could not start " << path << endl;
+                delete mediocre;
+                return 1;
+            }
+            ostringstream quiet;
+            streambuf* old = cout.rdbuf(quiet.rdbuf());
+            Player* winner = (k % 2 == 0 ? g.play(bot, mediocre, false) : g.play(mediocre, bot, false));
+            cout.rdbuf(old);
+            if (winner == bot)
+                botWins++;
+            BotTiming t = botTiming(bot);
+            timing.mean_micros = (timing.mean_micros * timing.round_trips + t.mean_micros * t.round_trips) /
+                                 max(1L, timing.round_trips + t.round_trips);
+            timing.round_trips += t.round_trips;
+            timing.max_micros = max(timing.max_micros, t.max_micros);
+            if (k == NGAMES - 1)
+                ping = pingBot(bot, NPINGS);
+            delete bot;
+            delete mediocre;
+        }
+        cout << "The bot won " << botWins << " out of " << NGAMES << " games." << endl;
+        cout << "  " << timing.round_trips << " moves asked of the bot, " << timing.mean_micros
+             << " microseconds per round trip on average (" << timing.max_micros << " at most)" << endl;
+        cout << "  " << ping << " microseconds per round trip with no thinking (" << NPINGS << " pings)" << endl;
+    }
+    else if (line == "11")
+    {
+        const int NGAMES = 4;
+        TimeControl tc = { 100, 3000, 25 };     // 0.1 seconds a move, 3 seconds a game plus 0.025 a move
+        string types[2] = { "good", "entropy" };
+        int wins[2] = { 0, 0 };
+        int flagged[2] = { 0, 0 };
+        MoveTimes times[2] = { { 0, 0, 0, false }, { 0, 0, 0, false } };
+        for (int k = 0; k < NGAMES; k++)
+        {
+            Game g(10, 10);
+            addStandardShips(g);
+            g.setTimeControl(tc);
+            Player* p[2] = { createPlayer(types[0], "Good Garrett", g), createPlayer(types[1], "Entropy Emma", g) };
+            ostringstream quiet;
+            streambuf* old = cout.rdbuf(quiet.rdbuf());
+            Player* winner = (k % 2 == 0 ? g.play(p[0], p[1], false) : g.play(p[1], p[0], false));
+            cout.rdbuf(old);
+            for (int i = 0; i < 2; i++)
+            {
+                MoveTimes t = g.moveTimes(p[i]);
+                if (winner == p[i])
+                    wins[i]++;
+                if (t.flagged)
+                    flagged[i]++;
+                times[i].moves += t.moves;
+                times[i].totalMillis += t.totalMillis;
+                times[i].maxMillis = max(times[i].maxMillis, t.maxMillis);
+            }
+            delete p[0];
+            delete p[1];
+        }
+        cout << "Each player had " << tc.moveMillis << " ms a move and " << tc.totalMillis << " ms a game, plus "
+             << tc.incrementMillis << " ms a move." << endl;
+        for (int i = 0; i < 2; i++)
+        {
+            cout << "  " << types[i] << " won " << wins[i] << " of " << NGAMES << " games and lost "
+                 << flagged[i] << " on time; " << times[i].moves << " moves, "
+                 << times[i].totalMillis / max(1L, times[i].moves) << " ms a move on average ("
+                 << times[i].maxMillis << " at most)" << endl;
+        }
+    }
+    else if (line == "12")
+    {
+        Game g(10, 10);
+        addStandardShips(g);
+        g.setSalvo(SALVO_ONE_PER_SHIP);
+        Player* p1 = createPlayer("mediocre", "Mediocre Marc", g);
+        Player* p2 = createPlayer("good", "Good Garrett", g);
+        cout << "This is a salvo game: each turn a player fires a shot for each of its ships still afloat" << endl << endl;
+        g.play(p1, p2);
+        delete p1;
+        delete p2;
+    }
+    else if (line == "13")
+    {
+        const int NPOSITIONS = 40;
+        const int REPEATS = 4;
+        const double BUDGETS[] = { 1, 10, 100 };
+        Game g(6, 6);
+        g.addShip(4, 'B', "battleship");
+        g.addShip(3, 'D', "destroyer");
+        g.addShip(3, 'S', "submarine");
+        g.addShip(2, 'P', "patrol boat");
+        seedRandom(1);
+        auto start = chrono::steady_clock::now();
+        vector<ExactPosition> corpus = make_accuracy_corpus(g, NPOSITIONS, 3, 16);
+        double layouts = 0;
+        for (size_t k = 0; k < corpus.size(); k++)
+            layouts += corpus[k].layouts;
+        cout << NPOSITIONS << " positions on a 6x6 board with 4 ships, solved exactly in "
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s ("
+             << layouts / NPOSITIONS << " layouts fit a position on average)" << endl;
+        cout << "Each position is estimated " << REPEATS << " times; errors are over unshot cells" << endl << endl;
+        cout << "estimator   ms  layouts    mean err  rms err  max err  argmax  regret  bias" << endl;
+        string types[4] = { "sampler", "exhaustive", "rejection", "density" };
+        for (int t = 0; t < 4; t++)
+        {
+            Estimator* e = createEstimator(types[t]);
+            for (double budget : BUDGETS)
+            {
+                AccuracyScore a = score_estimator(*e, g, corpus, budget, REPEATS);
+                printf("%-10s %4.0f %8.0f    %.4f    %.4f   %.4f   %5.1f%%  %.4f  %.4f\n", e->name().c_str(), budget,
+                       a.layouts, a.meanError, a.rmsError, a.maxError, 100 * a.argmaxAgreement, a.regret, a.bias);
+            }
+            delete e;
+        }
+    }
+    else if (line == "14")
+    {
+        /*
+         Each fleet fills about half the board: n ships of around 45/n cells (1 to 5).
+         For each, positions part way through a game (a third of the cells shot) go onto a possibilities board,
+         which samples on this thread alone for SAMPLE_MILLIS, timing every sample,
+         and then runs Possibilities_Board::sample (all threads) with a limit of LIMIT_MILLIS to see how far past it it goes
+         */
+        const int FLEETS[] = { 5, 10, 20, 30, 40, 50 };
+        const int NPOSITIONS = 10;
+        const double SAMPLE_MILLIS = 20;
+        const double LIMIT_MILLIS = 50;
+        string symbols;
+        for (char c = '!'; c <= '~'; c++)
+            if (c != 'X' && c != '.' && c != 'o' && c != '-')
+                symbols += c;
+        cout << "ships  cells  samples/s  accepted  slowest sample  " << LIMIT_MILLIS << " ms limit took" << endl;
+        for (int n : FLEETS)
+        {
+            Game g(10, 10);
+            int cells = 0;
+            for (int i = 0; i < n; i++)
+            {
+                int length = max(1, min(5, static_cast<int>(45.0 / n + 0.5) + i % 3 - 1));
+                g.addShip(length, symbols[i], string("ship ") + symbols[i]);
+                cells += length;
+            }
+            seedRandom(n);
+            vector<Position> positions;
+            for (int k = 0; k < NPOSITIONS; k++)
+                positions.push_back(random_position(g, 33, 33));
+            long attempts = 0, accepted = 0;
+            double seconds = 0, slowest = 0, overrun = 0;
+            for (const Position& p : positions)
+            {
+                Possibilities_Board board(g);
+                load_position(g, p, board);
+                board.determine_locations();
+                vector<int> counts(100, 0);
+                auto start = chrono::steady_clock::now();
+                while (chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() < SAMPLE_MILLIS)
+                {
+                    auto before = chrono::steady_clock::now();
+                    if (board.place_ships() && board.is_valid_board())
+                    {
+                        board.read_to(counts);
+                        accepted++;
+                    }
+                    board.unplace_all_ships();
+                    attempts++;
+                    slowest = max(slowest, chrono::duration<double, micro>(chrono::steady_clock::now() - before).count());
+                }
+                seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                start = chrono::steady_clock::now();
+                board.sample(counts, 100000000, LIMIT_MILLIS);
+                overrun = max(overrun, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            }
+            printf("%5d  %5d  %9.0f  %7.1f%%  %10.0f us  %10.1f ms\n", n, cells, accepted / seconds,
+                   100.0 * accepted / max(1L, attempts), slowest, overrun);
+            fflush(stdout);
+        }
+    }
+    else if (line == "15")
+    {
+        /*
+         NGAMES games are played twice: one after another with Game::play,
+         then all together on this thread, stepping each in turn (see Game::step) and only yielding
+         once every game is waiting on its bot. Each bot is its own process, so while one thinks the others can too
+         */
+        const int NGAMES = 64;
+        string path;
+        cout << "Enter the path of the bot (build bots/ReferenceBot.cpp for one): ";
+        cin >> path;
+        for (int together = 0; together < 2; together++)
+        {
+            vector<Game*> games;
+            vector<Player*> bots, others;
+            for (int k = 0; k < NGAMES; k++)
+            {
+                games.push_back(new Game(10, 10));
+                addStandardShips(*games[k]);
+                bots.push_back(createPlayer("bot:" + path, "Bot", *games[k]));
+                others.push_back(createPlayer("mediocre", "Mediocre Mimi", *games[k]));
+                if (bots[k] == nullptr)
+                {
+                    cout << "Could not start " << path << endl;
+                    return 1;
+                }
+            }
+            int botWins = 0;
+            long steps = 0, waits = 0;
+            ostringstream quiet;
+            streambuf* old = cout.rdbuf(quiet.rdbuf());
+            auto start = chrono::steady_clock::now();
+            if (!together)
+            {
+                for (int k = 0; k < NGAMES; k++)
+                {
+                    if (games[k]->play(bots[k], others[k], false) == bots[k])
+                        botWins++;
+                }
+            }
+            else
+            {
+                for (int k = 0; k < NGAMES; k++)
+                    games[k]->start(bots[k], others[k], false);
+                vector<bool> over(NGAMES, false);
+                for (int left = NGAMES; left > 0; )
+                {
+                    bool stepped = false;
+                    for (int k = 0; k < NGAMES; k++)
+                    {
+                        if (over[k])
+                            continue;
+                        GameStep s = games[k]->step();
+                        steps++;
+                        if (s == GAME_STEPPED)
+                            stepped = true;
+                        else if (s == GAME_OVER)
+                        {
+                            over[k] = true;
+                            left--;
+                            if (games[k]->winner() == bots[k])
+                                botWins++;
+                        }
+                    }
+                    if (!stepped)
+                    {
+                        waits++;
+                        this_thread::yield();
+                    }
+                }
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout.rdbuf(old);
+            cout << (together ? "All at once:     " : "One at a time:   ") << botWins << " bot wins of " << NGAMES
+                 << " in " << seconds << " s";
+            if (together)
+                cout << " (" << steps << " steps, " << waits << " times every game was waiting)";
+            cout << endl;
+            for (int k = 0; k < NGAMES; k++)
+            {
+                delete bots[k];
+                delete others[k];
+                delete games[k];
+            }
+        }
+    }
     else if (line[0] == '1')
     {
         Game g(2, 3);
@@ -84,6 +494,8 @@ int main()
     else if (line[0] == '4')
     {
         int nMediocreWins = 0;
+        ForcedShots forced = { 0, 0 };
+        ExhaustedSamples exhausted = { 0, 0, 0 };
 
         for (int k = 1; k <= NTRIALS; k++)
         {
@@ -97,15 +509,162 @@ int main()
                                 g.play(p1, p2, false) : g.play(p2, p1, false));
             if (winner == p2)
                 nMediocreWins++;
+            forced.attacks += forcedShots(p1).attacks;
+            forced.forced += forcedShots(p1).forced;
+            exhausted.samplings += exhaustedSamples(p1).samplings;
+            exhausted.exhausted += exhaustedSamples(p1).exhausted;
+            exhausted.layouts += exhaustedSamples(p1).layouts;
             delete p1;
             delete p2;
         }
         cout << "The mediocre player won " << nMediocreWins << " out of "
              << NTRIALS << " games." << endl;
+        cout << forced.forced << " of the good player's " << forced.attacks
+             << " shots were certain hits and skipped sampling." << endl;
+        cout << exhausted.exhausted << " of its " << exhausted.samplings
+             << " samplings found every layout there was (" << exhausted.layouts
+             << " in all) and counted them exactly." << endl;
           // We'd expect a mediocre player to win most of the games against
           // an awful player.  Similarly, a good player should outperform
           // a mediocre player.
     }
+    else if (line[0] == '5')
+    {
+        const long MAXGAMES = 10000;
+        string first, second;
+        cout << "Enter two player types (awful, mediocre, good, entropy): ";
+        cin >> first >> second;
+        const string CHECKPOINT = "tournament_checkpoint.bin";
+        Tournament t(first, second, 10, 10, addStandardShips);
+        if (t.resume(CHECKPOINT))
+            cout << "Resuming the interrupted match from " << CHECKPOINT << endl;
+        t.set_checkpoint(CHECKPOINT, 10);
+        long played = t.run(MAXGAMES, true);
+        if (played == MAXGAMES)
+            cout << "Stopped after the maximum of " << MAXGAMES << " games." << endl;
+        t.report();
+        remove(CHECKPOINT.c_str());  // the match is over, so there is nothing left to resume
+        SchedulerStats stats = ThreadPool::instance().stats();
+        cout << "  " << stats.tasks_run << " tasks on " << stats.workers << " worker threads (plus this one), "
+             << stats.steals << " steals, " << 100 * stats.utilization << "% worker utilization" << endl;
+    }
+    else if (line[0] == '6')
+    {
+        const long NLAYOUTS = 1000;
+        const string CORPUS = "standard_layouts.bin";
+        string first, second;
+        cout << "Enter two player types (awful, mediocre, good, entropy): ";
+        cin >> first >> second;
+        Game g(10, 10);
+        addStandardShips(g);
+        LayoutCorpus corpus;
+        if (!corpus.open(CORPUS, g))
+        {
+            cout << "Generating " << NLAYOUTS << " layouts into " << CORPUS << endl;
+            if (!LayoutCorpus::generate(CORPUS, g, NLAYOUTS)  ||  !corpus.open(CORPUS, g))
+            {
+                cout << "Could not create the layout corpus." << endl;
+                return 1;
+            }
+        }
+        Tournament t(first, second, 10, 10, addStandardShips);
+        t.run_paired(corpus, corpus.size(), true);
+        t.report_paired();
+    }
+    else if (line[0] == '7')
+    {
+        const size_t NGAMES = 1000000;
+        const long NCLASSIC = 100;
+        Game g(10, 10);
+        addStandardShips(g);
+        SimulationFleet fleet;
+        fleet.configure(g);
+        vector<CompactGame> games(NGAMES);
+        cout << "Each game in flight takes " << sizeof(CompactGame) << " bytes, "
+             << sizeof(CompactGame) * NGAMES / (1024 * 1024) << " MB for " << NGAMES << " games" << endl;
+
+          // heap allocations are counted by bench/Allocations.cpp, a program of its own
+        auto start = chrono::steady_clock::now();
+        long firstWins = simulate_games(fleet, SIM_HUNT, SIM_HUNT, games.data(), NGAMES, 1);
+        chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        cout << "The first player won " << firstWins << " of " << NGAMES << " games in " << seconds.count()
+             << " seconds (" << NGAMES / seconds.count() << " games per second)" << endl;
+
+        Tournament t("mediocre", "mediocre", 10, 10, addStandardShips);
+        start = chrono::steady_clock::now();
+        t.run(NCLASSIC, false);
+        seconds = chrono::steady_clock::now() - start;
+        cout << "For comparison, Game::play managed " << NCLASSIC / seconds.count() << " games per second" << endl;
+    }
+    else if (line[0] == '8')
+    {
+        const size_t NGAMES = 1 << 18;
+        const size_t BATCH = 4096;
+        Game g(10, 10);
+        addStandardShips(g);
+        SimulationFleet fleet;
+        fleet.configure(g);
+        SimStrategy strategies[2] = { SIM_SWEEP, SIM_HUNT };
+        string names[2] = { "awful", "mediocre" };
+        for (int k = 0; k < 2; ++k)
+        {
+            vector<CompactGame> games(BATCH);
+            long firstWins = 0;
+            auto start = chrono::steady_clock::now();
+            for (size_t done = 0; done < NGAMES; done += BATCH)
+                firstWins += simulate_games(fleet, strategies[k], SIM_HUNT, games.data(), BATCH, done);
+            chrono::duration<double> scalar = chrono::steady_clock::now() - start;
+
+            BatchSimulation batch(fleet, BATCH);
+            start = chrono::steady_clock::now();
+            long batchFirstWins = batch.run(strategies[k], SIM_HUNT, 0, NGAMES);
+            chrono::duration<double> lockstep = chrono::steady_clock::now() - start;
+
+            cout << names[k] << " vs mediocre, " << NGAMES << " games:" << endl;
+            cout << "  one at a time: " << NGAMES / scalar.count() << " games per second, first player won "
+                 << firstWins << endl;
+            cout << "  lockstep:      " << NGAMES / lockstep.count() << " games per second, first player won "
+                 << batchFirstWins << endl;
+        }
+    }
+    else if (line[0] == '9')
+    {
+        const unsigned int SEED = 1;
+        string first, second;
+        long nGames, nShards;
+        cout << "Enter two player types (awful, mediocre, good, entropy), the number of games and of shards: ";
+        cin >> first >> second >> nGames >> nShards;
+        if (!cin  ||  nGames < 1  ||  nShards < 1  ||  nShards > nGames)
+        {
+            cout << "That's not a sensible match." << endl;
+            return 1;
+        }
+          // Each shard is played by a child process, which is all a shard on another machine would be
+        Tournament t(first, second, 10, 10, addStandardShips, SEED);
+        vector<string> paths;
+        for (long k = 0; k < nShards; k++)
+        {
+            paths.push_back("shard_" + to_string(k) + ".bin");
+            if (fork() == 0)
+                _exit(t.run_shard(nGames * k / nShards, nGames * (k + 1) / nShards, paths[k]) ? 0 : 1);
+        }
+        while (wait(nullptr) > 0)
+            ;
+        if (t.merge_shards(paths, false) < 0)
+        {
+            cout << "Some shards did not finish." << endl;
+            return 1;
+        }
+        cout << "Merged from " << nShards << " shards:" << endl;
+        t.report();
+        for (size_t k = 0; k < paths.size(); k++)
+            remove(paths[k].c_str());
+
+        Tournament single(first, second, 10, 10, addStandardShips, SEED);
+        single.run(nGames, false);
+        cout << "Played in this process alone:" << endl;
+        single.report();
+    }
     else
     {
        cout << "That's not one of the choices." << endl;